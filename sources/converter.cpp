@@ -0,0 +1,51 @@
+#include "header.hpp"
+
+
+namespace fs = std::filesystem;
+
+
+int main(int argc, char const* argv[])
+{
+    if (argc < 3) {
+        std::cerr << "Usage:" << std::endl;
+        std::cerr << "    ./conf_converter input.xml output.bin" << std::endl;
+        std::cerr << "    ./conf_converter input_dir output_dir" << std::endl;
+        return -1;
+    }
+
+    try {
+        fs::path input = argv[1];
+        fs::path output = argv[2];
+
+        // Directory is converted file by file, output files get the same
+        // names with extension .bin.
+        if (fs::is_directory(input)) {
+            fs::create_directories(output);
+
+            for (const auto& file: fs::directory_iterator(input)) {
+                fs::path output_file =
+                        output / file.path().filename().replace_extension(
+                                ".bin");
+
+                RecourceDistributor::save_bin_conf(
+                        RecourceDistributor::load_conf(file.path().string()),
+                        output_file.string());
+            }
+
+        } else {
+            RecourceDistributor::save_bin_conf(
+                    RecourceDistributor::load_conf(input.string()),
+                    output.string());
+        }
+
+    } catch (const std::string& err_message) {
+        std::cerr << err_message << std::endl;
+        return -2;
+
+    } catch (const fs::filesystem_error& error) {
+        std::cerr << error.what() << std::endl;
+        return -2;
+    }
+
+    return 0;
+}
@@ -6,12 +6,25 @@
 #include <string>
 #include <vector>
 #include <utility>
+#include <algorithm>
 #include <fstream>
 #include <unordered_map>
 #include <map>
+#include <limits>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <sstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <exception>
+#include <memory_resource>
+#include <array>
+#include <iomanip>
+#include <type_traits>
 
 
 // Struct to store information about each item of request or
@@ -29,9 +42,9 @@ struct Item
     {}
 };
 
-// Vector of pairs with cores number and RAM.
-using CharactVect = std::vector<Item>;
-using CharactVectWithIndices = std::vector<std::pair<Item, unsigned>>;
+// Vector of pairs with cores number and RAM. Scratch vectors of limited
+// search take memory from an arena, so polymorphic allocator is used.
+using CharactVect = std::pmr::vector<Item>;
 
 // Struct to store parsed XML data representation.
 template <typename T = CharactVect>
@@ -48,6 +61,41 @@ struct ParsingResult
     {}
 };
 
+// View of configuration items selected by indices: i-th item of the view
+// is item indices[i] of the configuration. It is used as ParsingResult
+// content to run the algorithm on subconfiguration without copying items.
+struct SubconfView
+{
+    const CharactVect& conf;
+    const std::pmr::vector<unsigned>& indices;
+
+    const Item& operator[](std::size_t i) const
+    {
+        return conf[indices[i]];
+    }
+
+    std::size_t size() const
+    {
+        return indices.size();
+    }
+};
+
+// Header of configuration in binary format. Values are written in native
+// byte order, byte_order keeps the marker as it was written, so files of
+// machines with other byte order are recognized.
+struct BinConfHeader
+{
+    static constexpr char valid_magic[4] = {'V', 'M', 'C', 'F'};
+    static constexpr uint32_t valid_version = 2;
+    static constexpr uint32_t native_byte_order = 0x01020304;
+
+    char magic[4];
+    uint32_t byte_order;
+    uint32_t version;
+    int32_t conf_num;
+    uint32_t item_num;
+};
+
 // Struct to store result of VM deployment.
 struct VmDeployment
 {
@@ -55,18 +103,443 @@ struct VmDeployment
     int serv_conf_num;
     unsigned deployed_vm_num;
     bool was_all_vm_deployed;
-    
+
+    // Server number of VM which wasn't deployed and end of VM lists.
+    static constexpr uint32_t unplaced = std::numeric_limits<uint32_t>::max();
+
     // Mapping: # VM -> # Server.
-    std::unordered_map<unsigned, unsigned> vm_mapping;
+    std::pmr::vector<uint32_t> vm_mapping;
+
+    // Reverse mapping: # Server -> list of VMs deployed on it. Lists are
+    // intrusive, serv_first_vm keeps the first VM of each server and
+    // vm_next/vm_prev link VMs of the same server.
+    std::pmr::vector<uint32_t> serv_first_vm;
+    std::pmr::vector<uint32_t> vm_next;
+    std::pmr::vector<uint32_t> vm_prev;
 
-    VmDeployment(int req_conf_num_ = 0, int serv_conf_num_ = 0)
+    VmDeployment(int req_conf_num_ = 0,
+                 int serv_conf_num_ = 0,
+                 std::size_t vm_num = 0,
+                 std::size_t serv_num = 0,
+                 std::pmr::memory_resource* mr =
+                         std::pmr::get_default_resource())
         : req_conf_num {req_conf_num_},
           serv_conf_num {serv_conf_num_},
           deployed_vm_num {0},
-          was_all_vm_deployed {false}
+          was_all_vm_deployed {false},
+          vm_mapping(vm_num, unplaced, mr),
+          serv_first_vm(serv_num, unplaced, mr),
+          vm_next(vm_num, unplaced, mr),
+          vm_prev(vm_num, unplaced, mr)
     {}
+
+    // Method to put VM on server (or move it there if it is already
+    // deployed) keeping both mappings consistent.
+    void deploy(uint32_t vm_num, uint32_t serv_num)
+    {
+        if (vm_mapping[vm_num] == serv_num) {
+            return;
+        }
+
+        unlink(vm_num);
+
+        vm_mapping[vm_num] = serv_num;
+        vm_prev[vm_num] = unplaced;
+        vm_next[vm_num] = serv_first_vm[serv_num];
+        if (vm_next[vm_num] != unplaced) {
+            vm_prev[vm_next[vm_num]] = vm_num;
+        }
+
+        serv_first_vm[serv_num] = vm_num;
+    }
+
+    // Method to add slot of a new undeployed VM. Returns number of it.
+    uint32_t add_vm()
+    {
+        vm_mapping.push_back(unplaced);
+        vm_next.push_back(unplaced);
+        vm_prev.push_back(unplaced);
+
+        return vm_mapping.size() - 1;
+    }
+
+    // Method to take deployed VM off its server in O(1) keeping both
+    // mappings consistent. Returns number of the server or unplaced if
+    // the VM wasn't deployed.
+    uint32_t release(uint32_t vm_num)
+    {
+        uint32_t serv_num = vm_mapping[vm_num];
+        if (serv_num == unplaced) {
+            return unplaced;
+        }
+
+        unlink(vm_num);
+        deployed_vm_num -= 1;
+        was_all_vm_deployed = false;
+
+        return serv_num;
+    }
+
+    // Method to call fn(vm_num) for every VM deployed on the server.
+    template <typename F>
+    void for_each_vm_on(uint32_t serv_num, F fn) const
+    {
+        for (uint32_t vm = serv_first_vm[serv_num];
+                vm != unplaced;
+                vm = vm_next[vm]) {
+            fn(vm);
+        }
+    }
+
+private:
+    // Method to remove VM from the list of its server.
+    void unlink(uint32_t vm_num)
+    {
+        if (vm_mapping[vm_num] == unplaced) {
+            return;
+        }
+
+        if (vm_prev[vm_num] != unplaced) {
+            vm_next[vm_prev[vm_num]] = vm_next[vm_num];
+
+        } else {
+            serv_first_vm[vm_mapping[vm_num]] = vm_next[vm_num];
+        }
+
+        if (vm_next[vm_num] != unplaced) {
+            vm_prev[vm_next[vm_num]] = vm_prev[vm_num];
+        }
+
+        vm_mapping[vm_num] = unplaced;
+    }
 };
 
+// Struct to store free resources of servers used by the algorithm.
+// Every resource is kept in its own column (structure of arrays), j-th
+// element of a column corresponds to j-th server of configuration, so
+// feasibility checks over many servers read memory sequentially.
+struct ServerWorkspace
+{
+    std::pmr::vector<uint32_t> free_core_num;
+    std::pmr::vector<uint32_t> free_ram;
+
+    ServerWorkspace() = default;
+
+    // Workspace of empty servers of the configuration (CharactVect or
+    // SubconfView).
+    template <typename T>
+    explicit ServerWorkspace(const T& serv_conf,
+                             std::pmr::memory_resource* mr =
+                                     std::pmr::get_default_resource())
+        : free_core_num(serv_conf.size(), mr),
+          free_ram(serv_conf.size(), mr)
+    {
+        for (unsigned j = 0; j < serv_conf.size(); j++) {
+            free_core_num[j] = serv_conf[j].core_num;
+            free_ram[j] = serv_conf[j].ram;
+        }
+    }
+
+    std::size_t size() const
+    {
+        return free_core_num.size();
+    }
+
+    // Method to check that VM fits into the server.
+    bool fits(unsigned serv_num, const Item& vm) const
+    {
+        return vm.core_num <= free_core_num[serv_num] and
+               vm.ram <= free_ram[serv_num];
+    }
+
+    // Method to take resources of VM from the server.
+    void take(unsigned serv_num, const Item& vm)
+    {
+        free_core_num[serv_num] -= vm.core_num;
+        free_ram[serv_num] -= vm.ram;
+    }
+
+    // Method to return resources of VM to the server.
+    void give_back(unsigned serv_num, const Item& vm)
+    {
+        free_core_num[serv_num] += vm.core_num;
+        free_ram[serv_num] += vm.ram;
+    }
+};
+
+// Struct to store state of a single run of the algorithm, so that
+// a distributor can run several placements concurrently.
+struct PlacementContext
+{
+    // Flag showing that number of cores is critical resource.
+    bool core_num_is_critical = false;
+
+    // Searching depth of limited search.
+    unsigned limit = 0;
+
+    // Buffer and arena for scratch containers of limited search. The
+    // arena is released before every search, so the buffer is reused and
+    // the heap is used only by searches which don't fit into it. The
+    // buffer isn't zeroed, so runs without limited search don't touch it.
+    std::unique_ptr<std::byte[]> arena_buffer;
+    std::pmr::monotonic_buffer_resource arena;
+
+    explicit PlacementContext(std::size_t arena_size)
+        : arena_buffer {new std::byte[arena_size]},
+          arena {arena_buffer.get(), arena_size}
+    {}
+};
+
+// Struct to store state of greedy algorithm before the first VM which
+// needs limited search. The state is the same for every searching depth,
+// so runs with different depths continue from a copy of it.
+struct PlacementCheckpoint
+{
+    VmDeployment vm_depl;
+    ServerWorkspace ws;
+
+    // Number of the VM to continue from.
+    unsigned next_vm = 0;
+};
+
+// Policy of choosing server for VM in greedy algorithm.
+enum class PlacementPolicy
+{
+    // The first server in configuration order which can contain VM.
+    first_fit,
+
+    // The server with the least remaining critical resource which can
+    // contain VM.
+    best_fit
+};
+
+// Class finding server for VM according to placement policy. It keeps
+// reference to server workspace and should be notified about every
+// change of it.
+class ServerSelector
+{
+public:
+    ServerSelector(PlacementPolicy policy,
+                   bool core_num_is_critical,
+                   const ServerWorkspace& ws,
+                   std::pmr::memory_resource* mr =
+                           std::pmr::get_default_resource());
+
+    // Method to find server which can contain VM. Returns number of
+    // servers if there is no such server.
+    unsigned find(const Item& vm) const;
+
+    // Method to update selector after free resources of the server
+    // were changed.
+    void update(unsigned serv_num);
+
+    // Method to collect up to limit servers with numbers less than
+    // serv_end in descending order of remaining critical resource.
+    // Servers with equal resource go in descending order of numbers.
+    void collect_by_remaining(unsigned serv_end,
+                              unsigned limit,
+                              std::pmr::vector<unsigned>& servers);
+
+private:
+    PlacementPolicy policy_;
+    bool core_num_is_critical_;
+
+    // Flag showing that servers are kept ordered by remaining critical
+    // resource. Best fit needs the order from the start, for first fit
+    // it is built when selections of top servers have cost enough.
+    bool keep_order_;
+    std::size_t selection_cost_ = 0;
+
+    const ServerWorkspace& ws_;
+
+    // Number of servers in a leaf of segment tree. Servers of a leaf
+    // are checked by a vectorized scan.
+    static constexpr unsigned block_size_ = 64;
+
+    // Segment tree over blocks of servers keeping maximum of remaining
+    // cores and RAM in every subtree (first fit only). Leaves start at
+    // tree_size_.
+    unsigned tree_size_ = 0;
+    std::pmr::vector<unsigned> max_core_num_;
+    std::pmr::vector<unsigned> max_ram_;
+
+    // Treap of servers ordered by pairs <remaining_critical_resource :
+    // server_number>. Node of a server has its number, so updates don't
+    // allocate. Every node keeps the key of its server (remaining_ and
+    // the number), remaining other resource and maximum of the latter in
+    // its subtree, so subtrees where VM can't fit are skipped.
+    static constexpr unsigned nil_ = std::numeric_limits<unsigned>::max();
+    unsigned root_ = nil_;
+    std::pmr::vector<unsigned> left_;
+    std::pmr::vector<unsigned> right_;
+    std::pmr::vector<unsigned> remaining_;
+    std::pmr::vector<unsigned> other_;
+    std::pmr::vector<unsigned> max_other_;
+
+    // Method to get remaining critical resource of the server.
+    unsigned get_remaining(unsigned serv_num) const;
+
+    // Method to get remaining other resource of the server.
+    unsigned get_other(unsigned serv_num) const;
+
+    // Method to build treap of servers ordered by remaining resource.
+    void build_order();
+
+    // Method to find the least server in the order of treap which has
+    // at least need of critical resource and need_other of the other one
+    // in the subtree of the node.
+    unsigned find_best(unsigned node,
+                       unsigned need,
+                       unsigned need_other) const;
+
+    // Method to collect up to limit servers with numbers less than
+    // serv_end from the subtree of the node in descending order.
+    void collect_from(unsigned node,
+                      unsigned serv_end,
+                      unsigned limit,
+                      std::pmr::vector<unsigned>& servers) const;
+
+    // Methods to insert server into treap and erase it by its key.
+    void insert(unsigned serv_num);
+    void erase(unsigned serv_num);
+
+    // Method to split subtree of the node into servers with keys less
+    // than <remaining : serv_num> and the others.
+    void split(unsigned node,
+               unsigned remaining,
+               unsigned serv_num,
+               unsigned& less,
+               unsigned& not_less);
+
+    // Method to merge subtrees where all keys of the left one are less.
+    unsigned merge(unsigned left, unsigned right);
+
+    // Method to recompute maximum of other resource of the node.
+    void pull(unsigned node);
+
+    // Priority of node in treap, it is a hash of server number.
+    static unsigned priority(unsigned serv_num);
+
+    // Method to find the first server which can contain VM in the
+    // subtree of the node.
+    unsigned find_first(const Item& vm, unsigned node) const;
+
+    // Method to recompute maximums of the leaf from its servers.
+    void update_leaf(unsigned block_num);
+};
+
+// Struct to store aggregate statistics of configuration. Histograms
+// count items by power-of-two buckets: bucket k holds values from 2^k
+// to 2^(k + 1) - 1 (zero values are in bucket 0).
+struct ConfStats
+{
+    static constexpr unsigned bucket_num = 32;
+
+    std::uint64_t sum_core_num = 0;
+    std::uint64_t sum_ram = 0;
+    unsigned max_core_num = 0;
+    unsigned max_ram = 0;
+    unsigned min_core_num = 0;
+    unsigned min_ram = 0;
+    std::array<unsigned, bucket_num> core_num_hist {};
+    std::array<unsigned, bucket_num> ram_hist {};
+
+    ConfStats() = default;
+
+    explicit ConfStats(const CharactVect& conf);
+
+    // Method to get histogram bucket of value.
+    static unsigned bucket(unsigned value)
+    {
+        return value == 0 ? 0 : 31 - __builtin_clz(value);
+    }
+};
+
+// Struct to store configuration prepared for the algorithm. Items are
+// sorted by each resource once (in ascending order for requests and in
+// descending order for servers), so a run only chooses the ordering
+// according to the critical resource.
+struct PreparedConf
+{
+    ParsingResult<> by_core_num;
+    ParsingResult<> by_ram;
+    ConfStats stats;
+
+    const ParsingResult<>& sorted_by(bool core_num_is_critical) const
+    {
+        return core_num_is_critical ? by_core_num : by_ram;
+    }
+};
+
+// Vector of prepared configurations shared with the cache.
+using PreparedConfVect = std::vector<std::shared_ptr<const PreparedConf>>;
+
+// Cache of parsed configurations keyed by file path. An entry is reused
+// while modification time and size of the file stay the same.
+class ConfigCache
+{
+public:
+    using Loader = std::function<PreparedConf(const std::string&)>;
+
+    explicit ConfigCache(Loader loader)
+        : loader_ {std::move(loader)}
+    {}
+
+    // Method to get prepared configuration, loading the file only if it
+    // isn't cached yet or was changed since the last load.
+    std::shared_ptr<const PreparedConf> get(const std::string& path);
+
+private:
+    struct Entry
+    {
+        std::filesystem::file_time_type mtime;
+        std::uintmax_t size;
+        std::shared_ptr<const PreparedConf> conf;
+    };
+
+    Loader loader_;
+
+    std::unordered_map<std::string, Entry> entries_;
+    std::mutex mutex_;
+};
+
+// Class writing outputs of the sweep into a file in the order of their
+// indices regardless of the order in which they are committed. The file is
+// truncated and opened once, outputs are written in big blocks.
+class ResultWriter
+{
+public:
+    ResultWriter(const std::string& output_filename,
+                 std::size_t block_size = 1 << 20);
+
+    ~ResultWriter();
+
+    // Method to add output with given index. Can be called concurrently.
+    void commit(std::size_t index, std::string&& output);
+
+    // Method to write the rest of buffered outputs.
+    void close();
+
+private:
+    std::ofstream ofile_;
+    std::size_t block_size_;
+
+    // Outputs ready to be written.
+    std::string buffer_;
+
+    // Outputs committed before some output with a smaller index.
+    std::size_t next_index_ = 0;
+    std::map<std::size_t, std::string> pending_;
+
+    std::mutex mutex_;
+
+    // Method to write the buffer into the file.
+    void write_buffer();
+};
+
+// Stream socket connection of placement daemon.
+class Connection;
+
 // Main class distributing resources of Data Center.
 class RecourceDistributor
 {
@@ -74,22 +547,96 @@ public:
     RecourceDistributor(unsigned limit,
                         std::string req_dir = "../id/requests",
                         std::string serv_dir = "../id/servers",
-                        std::string output_filename = "../results/results.txt")
+                        std::string output_filename = "../results/results.txt",
+                        unsigned workers = 0,
+                        PlacementPolicy policy = PlacementPolicy::first_fit,
+                        bool skip_infeasible = false)
         : limit_ {limit},
           req_dir_ {req_dir},
           serv_dir_ {serv_dir},
-          output_filename_ {output_filename}
+          output_filename_ {output_filename},
+          workers_ {workers},
+          policy_ {policy},
+          skip_infeasible_ {skip_infeasible},
+          req_cache_ {std::make_shared<ConfigCache>(
+                  [](const std::string& input_file)
+                  {
+                      return prepare_conf(load_conf(input_file), true);
+                  })},
+          serv_cache_ {std::make_shared<ConfigCache>(
+                  [](const std::string& input_file)
+                  {
+                      return prepare_conf(load_conf(input_file), false);
+                  })}
         {
-            // Clean existing file.
-            std::ofstream ofile {output_filename_};
-            if (!ofile) {
-                throw std::string("File problem (probably invalid filename)");
+            // Zero number of workers means all hardware threads.
+            if (workers_ == 0) {
+                workers_ = std::max(1u, std::thread::hardware_concurrency());
             }
         }
 
     // Main public methon to run recources distribution.
     void distributeRecources();
 
+    // Method to run the algorithm with every searching depth from the list
+    // on all pairs of configurations and print the table of success rate
+    // per searching depth into an output stream. Deployments aren't
+    // written.
+    void sweepLimits(const std::vector<unsigned>& limits,
+                     std::ostream& out);
+
+    // Method to run placement daemon on Unix domain socket. Server
+    // configurations are loaded once, then every worker accepts
+    // connections and answers placement requests of them until the
+    // process gets SIGINT or SIGTERM, the socket file is removed then.
+    // Existing file is replaced only if it is the socket of a stopped
+    // daemon. A worker serves one connection until it is closed, so at
+    // most workers clients are served at the same time and the others
+    // wait.
+    void serve(const std::string& socket_path);
+
+    // Method to load configuration from XML or binary file.
+    static ParsingResult<> load_conf(const std::string& input_file);
+
+    // Method to save configuration in binary format. The file starts with
+    // BinConfHeader followed by columns of cores numbers and RAM, all
+    // values are 32-bit in native byte order (marked in the header).
+    static void save_bin_conf(const ParsingResult<>& conf,
+                              const std::string& output_file);
+
+    // Method to deploy request configuration on empty servers. Both
+    // configurations are reordered by the algorithm. It is safe to call
+    // this method concurrently.
+    VmDeployment place(ParsingResult<>& req_conf,
+                       ParsingResult<>& serv_conf) const;
+
+    // Method to deploy request configuration on empty servers when both
+    // configurations are already sorted according to the critical
+    // resource. It is safe to call this method concurrently.
+    VmDeployment place_sorted(const ParsingResult<>& req_conf,
+                              const ParsingResult<>& serv_conf,
+                              bool core_num_is_critical,
+                              unsigned limit) const;
+
+    // Method to sort configuration by cores number or RAM.
+    static void sort_conf(ParsingResult<>& conf,
+                          bool by_core_num,
+                          bool ascending);
+
+    // Method to sort configuration by both resources, in ascending order
+    // for requests and in descending order for servers.
+    static PreparedConf prepare_conf(ParsingResult<> conf, bool ascending);
+
+    // Method to find out whether number of cores is critical resource.
+    static bool is_core_num_critical(const ConfStats& req_stats,
+                                     const ConfStats& serv_stats);
+
+    // Method to prove that request configuration can't be fully deployed
+    // on servers. It returns the violated bound or an empty string if
+    // the configurations pass all checks.
+    static std::string find_infeasibility(const ConfStats& req_stats,
+                                          const ConfStats& serv_stats);
+
 private:
     // Searching depth of algorithm.
     unsigned limit_;
@@ -99,39 +646,204 @@ private:
 
     std::string output_filename_;
 
-    unsigned first_available_serv_num_ = 0;
+    // Number of threads running the sweep.
+    unsigned workers_;
 
-    // Flag showing that number of cores is critical resource.
-    bool core_num_is_critical_ = false;
+    // Policy of greedy algorithm.
+    PlacementPolicy policy_;
+
+    // Flag showing that pairs which provably can't be fully deployed are
+    // not placed and only the reason is printed for them.
+    bool skip_infeasible_;
+
+    // Maximum size of configuration data in a placement request.
+    static constexpr std::size_t max_request_size_ = 64 << 20;
+
+    // Prepared request and server configurations.
+    std::shared_ptr<ConfigCache> req_cache_;
+    std::shared_ptr<ConfigCache> serv_cache_;
+
+    // Method to load all request and server configurations from input
+    // directories through the caches.
+    void load_confs(PreparedConfVect& req_confs,
+                    PreparedConfVect& serv_confs) const;
+
+    // Method to answer requests of a connection. Request is one of the
+    // lines:
+    //   PLACE <server configuration number> <size>
+    //       followed by request configuration data of the given size in
+    //       XML or binary format, it is deployed on empty servers;
+    //   ONLINE <server configuration number> <cores|ram>
+    //       starts online placement on empty servers with the given
+    //       critical resource;
+    //   ADD <cores number> <RAM>
+    //       places VM online, answer is "<VM handle> -> <server number>";
+    //   REMOVE <VM handle>
+    //       removes VM placed online.
+    // Answer is a line "OK <size>" followed by the answer data or a line
+    // "ERROR <message>". Malformed PLACE or unknown request closes the
+    // connection after the error.
+    void serve_connection(
+            Connection& conn,
+            const std::unordered_map<int,
+                                     std::shared_ptr<const PreparedConf>>&
+                    serv_confs) const;
+
+    // Method to deploy request configuration data on empty servers and
+    // print the deployment.
+    std::string answer_placement(const PreparedConf& serv,
+                                 int serv_conf_num,
+                                 std::string& data) const;
+
+    // Method to parse configuration data in XML or binary format.
+    static ParsingResult<> parse_conf_data(char* data, std::size_t size);
 
     // Method to parse XML data.
-    ParsingResult<> parse_xml_data(const std::string& input_file);
-    
-    // Method implementing greedy algorithm with limited search.
-    VmDeployment algorithm(ParsingResult<>& req_conf,
-                           ParsingResult<>& serv_conf,
-                           CharactVect& serv_load,
-                           bool enable_lim_sch = true);
+    static ParsingResult<> parse_xml_data(char* data, std::size_t size);
+
+    // Method to read data in binary format.
+    static ParsingResult<> parse_bin_data(const char* data, std::size_t size);
     
-    // Method to print resulting deployment into an output file.
-    void print_depl_to_file(const VmDeployment& vm_depl,
+    // Method implementing greedy algorithm with limited search. It runs
+    // on whole configurations (T = CharactVect) or on subconfigurations
+    // (T = SubconfView), limited search is possible only for the former.
+    template <typename T>
+    VmDeployment algorithm(PlacementContext& ctx,
+                           const ParsingResult<T>& req_conf,
+                           const ParsingResult<T>& serv_conf,
+                           ServerWorkspace& ws,
+                           bool enable_lim_sch = true,
+                           std::pmr::memory_resource* mr =
+                                   std::pmr::get_default_resource()) const;
+
+    // Method running greedy algorithm from the VM first_vm on the given
+    // deployment and workspace. With stop_at_failure it stops before the
+    // first VM which can't be deployed greedily. It returns number of the
+    // VM where it stopped.
+    template <typename T>
+    unsigned deploy_from(PlacementContext& ctx,
+                         const ParsingResult<T>& req_conf,
+                         const ParsingResult<T>& serv_conf,
+                         VmDeployment& vm_depl,
+                         ServerWorkspace& ws,
+                         unsigned first_vm,
+                         bool enable_lim_sch,
+                         bool stop_at_failure,
+                         std::pmr::memory_resource* mr) const;
+
+    // Method to run greedy algorithm up to the first VM which needs
+    // limited search.
+    PlacementCheckpoint place_prefix(PlacementContext& ctx,
+                                     const ParsingResult<>& req_conf,
+                                     const ParsingResult<>& serv_conf) const;
+
+    // Method to finish the algorithm from a copy of the checkpoint with
+    // searching depth of the context.
+    VmDeployment place_from(PlacementContext& ctx,
+                            const PlacementCheckpoint& checkpoint,
                             const ParsingResult<>& req_conf,
-                            const ParsingResult<>& serv_conf);
+                            const ParsingResult<>& serv_conf) const;
+
+    // Method to get size of arena which is enough for limited search on
+    // the configurations in most cases.
+    static std::size_t arena_size(const ParsingResult<>& req_conf,
+                                  const ParsingResult<>& serv_conf);
+    
+    // Method to print resulting deployment into an output stream.
+    void print_depl(std::ostream& ofile,
+                    const VmDeployment& vm_depl,
+                    const ParsingResult<>& req_conf,
+                    const ParsingResult<>& serv_conf) const;
+
+    // Method to print the reason why the pair of configurations wasn't
+    // placed into an output stream.
+    void print_rejection(std::ostream& ofile,
+                         int req_conf_num,
+                         int serv_conf_num,
+                         const std::string& reason) const;
 
     // Method to deploy current VM.
     bool try_deploy_vm(VmDeployment& vm_delp,
                        unsigned vm_num,
                        unsigned serv_num,
-                       const ParsingResult<>& req_conf,
-                       const ParsingResult<>& serv_conf,
-                       CharactVect& serv_load);
+                       const Item& vm,
+                       ServerWorkspace& ws) const;
 
     // Method implementing limited search procedure.
-    void limited_search(VmDeployment& vm_delp,
-                           unsigned vm_num,
-                           const ParsingResult<>& req_conf,
-                           const ParsingResult<>& serv_conf,
-                           CharactVect& serv_load);
+    void limited_search(PlacementContext& ctx,
+                        ServerSelector& selector,
+                        VmDeployment& vm_delp,
+                        unsigned vm_num,
+                        const ParsingResult<>& req_conf,
+                        const ParsingResult<>& serv_conf,
+                        ServerWorkspace& ws) const;
+};
+
+// Class keeping deployment of VMs on servers between calls. VMs arrive and
+// depart one by one, every arriving VM is placed greedily on the current
+// free resources of servers. Deployed VMs are never moved, so there is no
+// limited search.
+class OnlinePlacement
+{
+public:
+    // Servers should be sorted by the critical resource in descending
+    // order as for the algorithm (PreparedConf::sorted_by). VMs aren't
+    // known in advance, so the caller chooses the critical resource.
+    OnlinePlacement(const ParsingResult<>& serv_conf,
+                    bool core_num_is_critical,
+                    PlacementPolicy policy = PlacementPolicy::first_fit);
+
+    OnlinePlacement(const OnlinePlacement&) = delete;
+    OnlinePlacement& operator=(const OnlinePlacement&) = delete;
+
+    // Handle of VM: generation of its slot in the high 32 bits and number
+    // of the slot in the low ones. Slots of removed VMs are reused with
+    // the next generation, so handles of removed VMs stay invalid.
+    using VmHandle = std::uint64_t;
+    static constexpr VmHandle no_vm = std::numeric_limits<VmHandle>::max();
+
+    // Method to place arriving VM. Returns handle of the VM or no_vm if
+    // no server can contain it.
+    VmHandle add_vm(const Item& vm);
+
+    // Method to remove departed VM and free resources of its server.
+    void remove_vm(VmHandle vm);
+
+    // Method to get number of the server (as in configuration) of the VM.
+    // Returns VmDeployment::unplaced for removed VMs.
+    uint32_t server_of(VmHandle vm) const;
+
+    const VmDeployment& deployment() const
+    {
+        return vm_depl_;
+    }
+
+    const ServerWorkspace& workspace() const
+    {
+        return ws_;
+    }
+
+private:
+    // Servers sorted by critical resource in descending order.
+    ParsingResult<> serv_conf_;
+
+    // Resources of VMs and generations of their slots by slot numbers.
+    CharactVect vms_;
+    std::vector<uint32_t> generations_;
+
+    // Slots of removed VMs, so deployment is bounded by the peak number
+    // of VMs while they arrive and depart.
+    std::vector<uint32_t> free_slots_;
+
+    ServerWorkspace ws_;
+    VmDeployment vm_depl_;
+
+    // Selector keeps reference to the workspace, so it goes after it.
+    ServerSelector selector_;
+
+    // Method to get slot of VM. Returns VmDeployment::unplaced if the
+    // handle isn't of a placed VM.
+    uint32_t slot_of(VmHandle vm) const;
 };
 
 
@@ -2,51 +2,1455 @@
 
 #include "pugixml.hpp"
 
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <csignal>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#endif
+
 namespace fs = std::filesystem;
 
 
-void RecourceDistributor::distributeRecources()
+// Class mapping a whole file into memory. Pages are mapped privately, so
+// the data can be modified (e.g. by in-place parsing) without changing
+// the file.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& filename)
+    {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::string("Error: Can't open file " + filename);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 and st.st_size > 0) {
+            size_ = st.st_size;
+            void* addr = mmap(nullptr, size_,
+                              PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                              fd, 0);
+            if (addr != MAP_FAILED) {
+                data_ = static_cast<char*>(addr);
+            }
+        }
+
+        close(fd);
+
+        if (data_ == nullptr) {
+            throw std::string("Error: Can't map file " + filename);
+        }
+    }
+
+    ~MappedFile()
+    {
+        munmap(data_, size_);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    char* data() const
+    {
+        return data_;
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+
+// Class of a stream socket connection with buffered reading. The socket
+// is closed with the object.
+class Connection
+{
+public:
+    explicit Connection(int fd)
+        : fd_ {fd},
+          buffer_(64 * 1024)
+    {}
+
+    ~Connection()
+    {
+        close(fd_);
+    }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    // Method to read a line without the line break. Returns false if the
+    // stream ends before the line.
+    bool read_line(std::string& line)
+    {
+        line.clear();
+        for (;;) {
+            char* first = buffer_.data() + begin_;
+            char* last = buffer_.data() + end_;
+            char* eol = std::find(first, last, '\n');
+            line.append(first, eol);
+            begin_ = eol - buffer_.data();
+            if (eol != last) {
+                begin_ += 1;
+                return true;
+            }
+
+            if (line.size() > max_line_size_) {
+                throw std::string("Error: Too long line");
+            }
+
+            if (!fill()) {
+                return false;
+            }
+        }
+    }
+
+    // Method to read exactly size bytes. Returns false if the stream ends
+    // before.
+    bool read_exact(std::string& data, std::size_t size)
+    {
+        data.clear();
+        data.reserve(size);
+        while (data.size() < size) {
+            if (begin_ == end_ and !fill()) {
+                return false;
+            }
+
+            std::size_t chunk = std::min(size - data.size(), end_ - begin_);
+            data.append(buffer_.data() + begin_, chunk);
+            begin_ += chunk;
+        }
+
+        return true;
+    }
+
+    // Method to write all data. Closed connection doesn't raise SIGPIPE.
+    void write_all(const std::string& data)
+    {
+        std::size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = send(fd_, data.data() + written,
+                             data.size() - written, MSG_NOSIGNAL);
+            if (n < 0 and errno == EINTR) {
+                continue;
+            }
+
+            if (n <= 0) {
+                throw std::string("Error: Can't write to socket");
+            }
+
+            written += n;
+        }
+    }
+
+private:
+    static constexpr std::size_t max_line_size_ = 4096;
+
+    int fd_;
+    std::vector<char> buffer_;
+    std::size_t begin_ = 0;
+    std::size_t end_ = 0;
+
+    // Method to read the next portion of data into the empty buffer.
+    // Returns false at the end of stream.
+    bool fill()
+    {
+        begin_ = 0;
+        end_ = 0;
+        for (;;) {
+            ssize_t n = recv(fd_, buffer_.data(), buffer_.size(), 0);
+            if (n < 0 and errno == EINTR) {
+                continue;
+            }
+
+            if (n < 0) {
+                throw std::string("Error: Can't read from socket");
+            }
+
+            end_ = n;
+            return n > 0;
+        }
+    }
+};
+
+
+// Run fn(0) ... fn(count - 1) on the given number of threads. Every thread
+// takes the next unprocessed index from a shared counter, so the threads
+// finished with cheap items take over the rest of the work. The first
+// exception thrown by fn is rethrown in the calling thread.
+static void parallel_for(std::size_t count,
+                         unsigned workers,
+                         const std::function<void(unsigned, std::size_t)>& fn)
+{
+    std::atomic<std::size_t> next_index {0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&](unsigned worker_num)
+                  {
+                      try {
+                          std::size_t i;
+                          while ((i = next_index++) < count) {
+                              fn(worker_num, i);
+                          }
+
+                      } catch (...) {
+                          std::lock_guard<std::mutex> lock(error_mutex);
+                          if (!error) {
+                              error = std::current_exception();
+                          }
+
+                          // Make other threads stop taking new items.
+                          next_index = count;
+                      }
+                  };
+
+    if (workers > count) {
+        workers = count;
+    }
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < workers; t++) {
+        threads.emplace_back(worker, t);
+    }
+
+    worker(0);
+
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+
+// Kernels of feasibility scan. Every kernel returns the first index in
+// [begin, end) such that free_core_num >= core_num and free_ram >= ram,
+// or end if there is no such index.
+using FitScanFn = std::size_t (*)(const uint32_t* free_core_num,
+                                  const uint32_t* free_ram,
+                                  std::size_t begin,
+                                  std::size_t end,
+                                  uint32_t core_num,
+                                  uint32_t ram);
+
+static std::size_t scan_fit_scalar(const uint32_t* free_core_num,
+                                   const uint32_t* free_ram,
+                                   std::size_t begin,
+                                   std::size_t end,
+                                   uint32_t core_num,
+                                   uint32_t ram)
+{
+    for (std::size_t j = begin; j < end; j++) {
+        if (free_core_num[j] >= core_num and free_ram[j] >= ram) {
+            return j;
+        }
+    }
+
+    return end;
+}
+
+#ifdef HAVE_X86_SIMD
+__attribute__((target("avx2")))
+static std::size_t scan_fit_avx2(const uint32_t* free_core_num,
+                                 const uint32_t* free_ram,
+                                 std::size_t begin,
+                                 std::size_t end,
+                                 uint32_t core_num,
+                                 uint32_t ram)
+{
+    // a >= b for unsigned values is checked as max(a, b) == a.
+    const __m256i need_core_num = _mm256_set1_epi32(core_num);
+    const __m256i need_ram = _mm256_set1_epi32(ram);
+
+    std::size_t j = begin;
+    for (; j + 8 <= end; j += 8) {
+        __m256i c = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(free_core_num + j));
+        __m256i r = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(free_ram + j));
+
+        __m256i ok = _mm256_and_si256(
+                _mm256_cmpeq_epi32(_mm256_max_epu32(c, need_core_num), c),
+                _mm256_cmpeq_epi32(_mm256_max_epu32(r, need_ram), r));
+
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(ok));
+        if (mask != 0) {
+            return j + __builtin_ctz(mask);
+        }
+    }
+
+    return scan_fit_scalar(free_core_num, free_ram, j, end, core_num, ram);
+}
+
+__attribute__((target("avx512f")))
+static std::size_t scan_fit_avx512(const uint32_t* free_core_num,
+                                   const uint32_t* free_ram,
+                                   std::size_t begin,
+                                   std::size_t end,
+                                   uint32_t core_num,
+                                   uint32_t ram)
+{
+    const __m512i need_core_num = _mm512_set1_epi32(core_num);
+    const __m512i need_ram = _mm512_set1_epi32(ram);
+
+    std::size_t j = begin;
+    for (; j + 16 <= end; j += 16) {
+        __m512i c = _mm512_loadu_si512(free_core_num + j);
+        __m512i r = _mm512_loadu_si512(free_ram + j);
+
+        __mmask16 mask = _mm512_mask_cmpge_epu32_mask(
+                _mm512_cmpge_epu32_mask(c, need_core_num),
+                r, need_ram);
+        if (mask != 0) {
+            return j + __builtin_ctz(mask);
+        }
+    }
+
+    return scan_fit_scalar(free_core_num, free_ram, j, end, core_num, ram);
+}
+#endif
+
+// Function choosing the widest kernel supported by the processor.
+static FitScanFn select_scan_fit()
+{
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return scan_fit_avx512;
+    }
+
+    if (__builtin_cpu_supports("avx2")) {
+        return scan_fit_avx2;
+    }
+#endif
+
+    return scan_fit_scalar;
+}
+
+static const FitScanFn scan_fit = select_scan_fit();
+
+// Function estimating number of steps to sort n elements, n * log2(n).
+static std::size_t sort_cost(std::size_t n)
+{
+    std::size_t cost = 0;
+    for (std::size_t m = n; m > 1; m /= 2) {
+        cost += n;
+    }
+
+    return cost;
+}
+
+ServerSelector::ServerSelector(PlacementPolicy policy,
+                               bool core_num_is_critical,
+                               const ServerWorkspace& ws,
+                               std::pmr::memory_resource* mr)
+    : policy_ {policy},
+      core_num_is_critical_ {core_num_is_critical},
+      keep_order_ {false},
+      ws_ {ws},
+      max_core_num_(mr),
+      max_ram_(mr),
+      left_(mr),
+      right_(mr),
+      remaining_(mr),
+      other_(mr),
+      max_other_(mr)
+{
+    if (policy_ == PlacementPolicy::first_fit) {
+        tree_size_ = 1;
+        while (tree_size_ * block_size_ < ws_.size()) {
+            tree_size_ *= 2;
+        }
+
+        // Leaves of absent blocks keep zeros, they are never returned
+        // because find_first() scans servers of a leaf.
+        max_core_num_.assign(2 * tree_size_, 0);
+        max_ram_.assign(2 * tree_size_, 0);
+        for (unsigned b = 0; b * block_size_ < ws_.size(); b++) {
+            update_leaf(b);
+        }
+
+        for (unsigned node = tree_size_ - 1; node >= 1; node--) {
+            max_core_num_[node] = std::max(max_core_num_[2 * node],
+                                           max_core_num_[2 * node + 1]);
+            max_ram_[node] = std::max(max_ram_[2 * node],
+                                      max_ram_[2 * node + 1]);
+        }
+    }
+
+    if (policy_ == PlacementPolicy::best_fit) {
+        build_order();
+    }
+}
+
+unsigned ServerSelector::find(const Item& vm) const
+{
+    if (policy_ == PlacementPolicy::first_fit) {
+        return find_first(vm, 1);
+    }
+
+    // Best fit: the least server in the order of remaining critical
+    // resource which fits both resources. Subtrees where the other
+    // resource is short are skipped, so it takes logarithmic time.
+    unsigned need = core_num_is_critical_ ? vm.core_num : vm.ram;
+    unsigned need_other = core_num_is_critical_ ? vm.ram : vm.core_num;
+    unsigned j = find_best(root_, need, need_other);
+
+    return j != nil_ ? j : ws_.size();
+}
+
+void ServerSelector::update(unsigned serv_num)
+{
+    if (policy_ == PlacementPolicy::first_fit) {
+        update_leaf(serv_num / block_size_);
+
+        unsigned node = tree_size_ + serv_num / block_size_;
+        for (node /= 2; node >= 1; node /= 2) {
+            max_core_num_[node] = std::max(max_core_num_[2 * node],
+                                           max_core_num_[2 * node + 1]);
+            max_ram_[node] = std::max(max_ram_[2 * node],
+                                      max_ram_[2 * node + 1]);
+        }
+    }
+
+    if (not keep_order_ or
+            (remaining_[serv_num] == get_remaining(serv_num) and
+             other_[serv_num] == get_other(serv_num))) {
+        return;
+    }
+
+    // The node of the server is reinserted with the new key.
+    erase(serv_num);
+    remaining_[serv_num] = get_remaining(serv_num);
+    other_[serv_num] = get_other(serv_num);
+    insert(serv_num);
+}
+
+void
+ServerSelector::collect_by_remaining(unsigned serv_end,
+                                     unsigned limit,
+                                     std::pmr::vector<unsigned>& servers)
+{
+    // Selection of top servers costs linear time, while building the
+    // ordered index costs O(M log M) once and O(log M) per update later.
+    // So the index is built after selections have cost as much as
+    // building it, which is never more than twice the better of them.
+    if (not keep_order_ and selection_cost_ >= sort_cost(ws_.size())) {
+        build_order();
+    }
+
+    if (keep_order_) {
+        collect_from(root_, serv_end, servers.size() + limit, servers);
+
+        return;
+    }
+
+    // Without the ordered index the top servers are selected from all
+    // servers below serv_end: nth_element moves them to the front in
+    // linear time and only they are sorted.
+    auto comparator = [this](unsigned left, unsigned right)
+                      {
+                          return std::make_pair(get_remaining(left), left) >
+                                 std::make_pair(get_remaining(right), right);
+                      };
+
+    std::size_t first = servers.size();
+    for (unsigned j = 0; j < serv_end; j++) {
+        servers.push_back(j);
+    }
+
+    selection_cost_ += serv_end;
+
+    std::size_t k = std::min<std::size_t>(limit, serv_end);
+    std::nth_element(servers.begin() + first,
+                     servers.begin() + first + k,
+                     servers.end(),
+                     comparator);
+
+    servers.resize(first + k);
+    std::sort(servers.begin() + first, servers.end(), comparator);
+}
+
+void ServerSelector::build_order()
+{
+    left_.assign(ws_.size(), nil_);
+    right_.assign(ws_.size(), nil_);
+    remaining_.resize(ws_.size());
+    other_.resize(ws_.size());
+    max_other_.resize(ws_.size());
+    for (unsigned j = 0; j < ws_.size(); j++) {
+        remaining_[j] = get_remaining(j);
+        other_[j] = get_other(j);
+        insert(j);
+    }
+
+    keep_order_ = true;
+}
+
+unsigned ServerSelector::get_remaining(unsigned serv_num) const
+{
+    if (core_num_is_critical_) {
+        return ws_.free_core_num[serv_num];
+
+    } else {
+        return ws_.free_ram[serv_num];
+    }
+}
+
+unsigned ServerSelector::get_other(unsigned serv_num) const
+{
+    if (core_num_is_critical_) {
+        return ws_.free_ram[serv_num];
+
+    } else {
+        return ws_.free_core_num[serv_num];
+    }
+}
+
+unsigned ServerSelector::find_best(unsigned node,
+                                   unsigned need,
+                                   unsigned need_other) const
+{
+    if (node == nil_ or max_other_[node] < need_other) {
+        return nil_;
+    }
+
+    // Keys of the left subtree are less, so it is skipped if the node
+    // has not enough critical resource.
+    if (remaining_[node] < need) {
+        return find_best(right_[node], need, need_other);
+    }
+
+    unsigned j = find_best(left_[node], need, need_other);
+    if (j != nil_) {
+        return j;
+    }
+
+    if (other_[node] >= need_other) {
+        return node;
+    }
+
+    return find_best(right_[node], need, need_other);
+}
+
+void ServerSelector::collect_from(unsigned node,
+                                  unsigned serv_end,
+                                  unsigned limit,
+                                  std::pmr::vector<unsigned>& servers) const
+{
+    if (node == nil_ or servers.size() >= limit) {
+        return;
+    }
+
+    collect_from(right_[node], serv_end, limit, servers);
+
+    if (node < serv_end and servers.size() < limit) {
+        servers.push_back(node);
+    }
+
+    collect_from(left_[node], serv_end, limit, servers);
+}
+
+void ServerSelector::insert(unsigned serv_num)
+{
+    left_[serv_num] = nil_;
+    right_[serv_num] = nil_;
+    max_other_[serv_num] = other_[serv_num];
+
+    unsigned less;
+    unsigned not_less;
+    split(root_, remaining_[serv_num], serv_num, less, not_less);
+    root_ = merge(merge(less, serv_num), not_less);
+}
+
+void ServerSelector::erase(unsigned serv_num)
+{
+    // The server is the only node with key not less than its key and
+    // less than the key of the next server number.
+    unsigned less;
+    unsigned not_less;
+    unsigned greater;
+    split(root_, remaining_[serv_num], serv_num, less, not_less);
+    split(not_less, remaining_[serv_num], serv_num + 1, not_less, greater);
+    root_ = merge(less, greater);
+}
+
+void ServerSelector::split(unsigned node,
+                           unsigned remaining,
+                           unsigned serv_num,
+                           unsigned& less,
+                           unsigned& not_less)
+{
+    if (node == nil_) {
+        less = nil_;
+        not_less = nil_;
+        return;
+    }
+
+    if (std::make_pair(remaining_[node], node) <
+            std::make_pair(remaining, serv_num)) {
+        split(right_[node], remaining, serv_num, right_[node], not_less);
+        less = node;
+
+    } else {
+        split(left_[node], remaining, serv_num, less, left_[node]);
+        not_less = node;
+    }
+
+    pull(node);
+}
+
+unsigned ServerSelector::merge(unsigned left, unsigned right)
+{
+    if (left == nil_) {
+        return right;
+    }
+
+    if (right == nil_) {
+        return left;
+    }
+
+    if (priority(left) > priority(right)) {
+        right_[left] = merge(right_[left], right);
+        pull(left);
+
+        return left;
+
+    } else {
+        left_[right] = merge(left, left_[right]);
+        pull(right);
+
+        return right;
+    }
+}
+
+void ServerSelector::pull(unsigned node)
+{
+    max_other_[node] = other_[node];
+    if (left_[node] != nil_) {
+        max_other_[node] = std::max(max_other_[node],
+                                    max_other_[left_[node]]);
+    }
+
+    if (right_[node] != nil_) {
+        max_other_[node] = std::max(max_other_[node],
+                                    max_other_[right_[node]]);
+    }
+}
+
+unsigned ServerSelector::priority(unsigned serv_num)
+{
+    unsigned h = serv_num * 0x9E3779B9u;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+
+    return h;
+}
+
+unsigned ServerSelector::find_first(const Item& vm, unsigned node) const
+{
+    // Maximums are taken separately for cores and RAM, so a subtree can
+    // be skipped only if one of them is too small. Otherwise the left
+    // subtree is searched first, which gives the same server as the
+    // linear scan.
+    if (max_core_num_[node] < vm.core_num or max_ram_[node] < vm.ram) {
+        return ws_.size();
+    }
+
+    if (node >= tree_size_) {
+        std::size_t begin = std::size_t(node - tree_size_) * block_size_;
+        std::size_t end = std::min(begin + block_size_, ws_.size());
+        std::size_t j = scan_fit(ws_.free_core_num.data(),
+                                 ws_.free_ram.data(),
+                                 begin, end,
+                                 vm.core_num, vm.ram);
+
+        return j < end ? j : ws_.size();
+    }
+
+    unsigned j = find_first(vm, 2 * node);
+    if (j < ws_.size()) {
+        return j;
+    }
+
+    return find_first(vm, 2 * node + 1);
+}
+
+void ServerSelector::update_leaf(unsigned block_num)
+{
+    std::size_t begin = std::size_t(block_num) * block_size_;
+    std::size_t end = std::min(begin + block_size_, ws_.size());
+
+    unsigned node = tree_size_ + block_num;
+    max_core_num_[node] = *std::max_element(ws_.free_core_num.begin() + begin,
+                                            ws_.free_core_num.begin() + end);
+    max_ram_[node] = *std::max_element(ws_.free_ram.begin() + begin,
+                                       ws_.free_ram.begin() + end);
+}
+
+ConfStats::ConfStats(const CharactVect& conf)
+{
+    if (conf.empty()) {
+        return;
+    }
+
+    min_core_num = std::numeric_limits<unsigned>::max();
+    min_ram = std::numeric_limits<unsigned>::max();
+    for (const auto& item: conf) {
+        sum_core_num += item.core_num;
+        sum_ram += item.ram;
+        max_core_num = std::max(max_core_num, item.core_num);
+        max_ram = std::max(max_ram, item.ram);
+        min_core_num = std::min(min_core_num, item.core_num);
+        min_ram = std::min(min_ram, item.ram);
+        ++core_num_hist[bucket(item.core_num)];
+        ++ram_hist[bucket(item.ram)];
+    }
+}
+
+std::shared_ptr<const PreparedConf>
+ConfigCache::get(const std::string& path)
+{
+    auto mtime = fs::last_write_time(path);
+    auto size = fs::file_size(path);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = entries_.find(path);
+        if (it != entries_.end() and
+                it->second.mtime == mtime and
+                it->second.size == size) {
+            return it->second.conf;
+        }
+    }
+
+    // Parse without holding the lock so that different files can be
+    // loaded concurrently.
+    auto conf = std::make_shared<const PreparedConf>(loader_(path));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[path] = Entry {mtime, size, conf};
+
+    return conf;
+}
+
+ResultWriter::ResultWriter(const std::string& output_filename,
+                           std::size_t block_size)
+    : ofile_ {output_filename, std::ios_base::trunc | std::ios_base::binary},
+      block_size_ {block_size}
+{
+    if (!ofile_) {
+        throw std::string("File problem (probably invalid filename)");
+    }
+
+    buffer_.reserve(block_size_);
+}
+
+ResultWriter::~ResultWriter()
+{
+    // Errors can't be reported from destructor, call close() to get them.
+    try {
+        close();
+
+    } catch (...) {
+    }
+}
+
+void ResultWriter::commit(std::size_t index, std::string&& output)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (index != next_index_) {
+        pending_.emplace(index, std::move(output));
+        return;
+    }
+
+    buffer_ += output;
+    next_index_ += 1;
+
+    // Move outputs waiting for this one to the buffer.
+    auto it = pending_.begin();
+    while (it != pending_.end() and it->first == next_index_) {
+        buffer_ += it->second;
+        next_index_ += 1;
+        it = pending_.erase(it);
+    }
+
+    if (buffer_.size() >= block_size_) {
+        write_buffer();
+    }
+}
+
+void ResultWriter::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (ofile_.is_open()) {
+        write_buffer();
+        ofile_.close();
+    }
+}
+
+void ResultWriter::write_buffer()
+{
+    ofile_.write(buffer_.data(), buffer_.size());
+    if (!ofile_) {
+        throw std::string("Error: Can't write results into the file");
+    }
+
+    buffer_.clear();
+}
+
+void RecourceDistributor::load_confs(PreparedConfVect& req_confs,
+                                     PreparedConfVect& serv_confs) const
+{
+    std::vector<std::string> serv_files;
+    for (const auto& serv_file: fs::directory_iterator(serv_dir_)) {
+        serv_files.emplace_back(serv_file.path().string());
+    }
+
+    std::vector<std::string> req_files;
+    for (const auto& req_file: fs::directory_iterator(req_dir_)) {
+        req_files.emplace_back(req_file.path().string());
+    }
+
+    // Every file is parsed and sorted only once.
+    serv_confs.assign(serv_files.size(), nullptr);
+    req_confs.assign(req_files.size(), nullptr);
+
+    parallel_for(serv_files.size() + req_files.size(),
+                 workers_,
+                 [&](unsigned, std::size_t i)
+                 {
+                     if (i < serv_files.size()) {
+                         serv_confs[i] = serv_cache_->get(serv_files[i]);
+
+                     } else {
+                         i -= serv_files.size();
+                         req_confs[i] = req_cache_->get(req_files[i]);
+                     }
+                 });
+}
+
+void RecourceDistributor::distributeRecources()
+{
+    PreparedConfVect req_confs;
+    PreparedConfVect serv_confs;
+    load_confs(req_confs, serv_confs);
+
+    // Output of every pair is written in the order of serial sweep, so
+    // the result file doesn't depend on the number of workers.
+    ResultWriter writer(output_filename_);
+
+    // For each pair of request x server_configuration run algorithm.
+    parallel_for(serv_confs.size() * req_confs.size(),
+                 workers_,
+                 [&](unsigned, std::size_t i)
+                 {
+                     const auto& req = *req_confs[i % req_confs.size()];
+                     const auto& serv = *serv_confs[i / req_confs.size()];
+
+                     std::ostringstream ss;
+                     if (skip_infeasible_) {
+                         std::string reason =
+                                 find_infeasibility(req.stats, serv.stats);
+                         if (not reason.empty()) {
+                             print_rejection(ss,
+                                             req.by_core_num.conf_num,
+                                             serv.by_core_num.conf_num,
+                                             reason);
+
+                             writer.commit(i, ss.str());
+                             return;
+                         }
+                     }
+
+                     // The algorithm runs on the orderings of cached
+                     // configurations according to the critical resource.
+                     bool core_num_is_critical =
+                             is_core_num_critical(req.stats, serv.stats);
+
+                     const auto& req_conf =
+                             req.sorted_by(core_num_is_critical);
+                     const auto& serv_conf =
+                             serv.sorted_by(core_num_is_critical);
+
+                     print_depl(ss,
+                                place_sorted(req_conf,
+                                             serv_conf,
+                                             core_num_is_critical,
+                                             limit_),
+                                req_conf, serv_conf);
+
+                     writer.commit(i, ss.str());
+                 });
+
+    writer.close();
+}
+
+void RecourceDistributor::sweepLimits(const std::vector<unsigned>& limits,
+                                      std::ostream& out)
+{
+    PreparedConfVect req_confs;
+    PreparedConfVect serv_confs;
+    load_confs(req_confs, serv_confs);
+
+    std::size_t pair_num = serv_confs.size() * req_confs.size();
+
+    // Every worker counts successful pairs per searching depth on its own,
+    // counters are summed up after the sweep.
+    std::vector<std::vector<unsigned>> success_nums(
+            workers_, std::vector<unsigned>(limits.size(), 0));
+
+    parallel_for(pair_num,
+                 workers_,
+                 [&](unsigned worker_num, std::size_t i)
+                 {
+                     const auto& req = *req_confs[i % req_confs.size()];
+                     const auto& serv = *serv_confs[i / req_confs.size()];
+
+                     // Pair which can't be fully deployed fails with every
+                     // searching depth.
+                     if (not find_infeasibility(req.stats,
+                                                serv.stats).empty()) {
+                         return;
+                     }
+
+                     bool core_num_is_critical =
+                             is_core_num_critical(req.stats, serv.stats);
+
+                     const auto& req_conf =
+                             req.sorted_by(core_num_is_critical);
+                     const auto& serv_conf =
+                             serv.sorted_by(core_num_is_critical);
+
+                     PlacementContext ctx(arena_size(req_conf, serv_conf));
+                     ctx.core_num_is_critical = core_num_is_critical;
+
+                     // Greedy algorithm doesn't depend on searching depth
+                     // up to the first VM which needs limited search, so
+                     // every depth continues from the state there.
+                     PlacementCheckpoint checkpoint =
+                             place_prefix(ctx, req_conf, serv_conf);
+
+                     for (unsigned k = 0; k < limits.size(); k++) {
+                         bool was_all_vm_deployed =
+                                 checkpoint.vm_depl.was_all_vm_deployed;
+
+                         if (checkpoint.next_vm <
+                                 req_conf.charact_vect.size()) {
+                             ctx.limit = limits[k];
+                             was_all_vm_deployed =
+                                     place_from(ctx,
+                                                checkpoint,
+                                                req_conf,
+                                                serv_conf)
+                                             .was_all_vm_deployed;
+                         }
+
+                         if (was_all_vm_deployed) {
+                             success_nums[worker_num][k] += 1;
+                         }
+                     }
+                 });
+
+    out << std::setw(10) << "lambda"
+        << std::setw(10) << "success"
+        << std::setw(10) << "pairs"
+        << std::setw(10) << "rate" << '\n';
+
+    for (unsigned k = 0; k < limits.size(); k++) {
+        unsigned success_num = 0;
+        for (const auto& worker_success_nums: success_nums) {
+            success_num += worker_success_nums[k];
+        }
+
+        double rate = pair_num == 0 ? 0.0
+                                    : 100.0 * success_num / pair_num;
+
+        out << std::setw(10) << limits[k]
+            << std::setw(10) << success_num
+            << std::setw(10) << pair_num
+            << std::setw(9) << std::fixed << std::setprecision(2) << rate
+            << "%\n";
+    }
+}
+
+void RecourceDistributor::serve(const std::string& socket_path)
 {
-    // For each pair of request x server_configuration run algorithm.
+    // Server configurations are found by their numbers.
+    std::unordered_map<int, std::shared_ptr<const PreparedConf>> serv_confs;
     for (const auto& serv_file: fs::directory_iterator(serv_dir_)) {
-        for (const auto& req_file: fs::directory_iterator(req_dir_)) {
-            ParsingResult req_conf =
-                    parse_xml_data(req_file.path().string());
-            
-            ParsingResult serv_conf =
-                    parse_xml_data(serv_file.path().string());
-
-            // Vector containing information about current loading of
-            // the servers.
-            // In spite of value type Item the field .num should be ignored
-            // because order of items in this container corresponds with
-            // order in serv_conf_.charact_vect.
-            CharactVect serv_load =
-                    std::vector(serv_conf.charact_vect.size(), Item());
-
-            print_depl_to_file(algorithm(req_conf, serv_conf, serv_load),
-                               req_conf, serv_conf);
+        auto serv = serv_cache_->get(serv_file.path().string());
+        serv_confs[serv->by_core_num.conf_num] = serv;
+    }
+
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        throw std::string("Error: Too long socket path " + socket_path);
+    }
+
+    std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    // Only socket file of a stopped daemon is replaced.
+    struct stat st;
+    if (lstat(socket_path.c_str(), &st) == 0) {
+        if (not S_ISSOCK(st.st_mode)) {
+            throw std::string("Error: " + socket_path +
+                              " exists and is not a socket");
+        }
+
+        int probe_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool is_alive = probe_fd >= 0 and
+                        connect(probe_fd,
+                                reinterpret_cast<const sockaddr*>(&addr),
+                                sizeof(addr)) == 0;
+        if (probe_fd >= 0) {
+            close(probe_fd);
+        }
+
+        if (is_alive) {
+            throw std::string("Error: Daemon is already running on " +
+                              socket_path);
+        }
+
+        unlink(socket_path.c_str());
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw std::string("Error: Can't create socket");
+    }
+
+    if (bind(listen_fd,
+             reinterpret_cast<const sockaddr*>(&addr),
+             sizeof(addr)) < 0) {
+        close(listen_fd);
+        throw std::string("Error: Can't bind socket " + socket_path);
+    }
+
+    if (listen(listen_fd, SOMAXCONN) < 0) {
+        close(listen_fd);
+        unlink(socket_path.c_str());
+        throw std::string("Error: Can't listen on socket " + socket_path);
+    }
+
+    // Sockets of connections being served by workers, so that they can
+    // be shut down when the daemon stops.
+    std::vector<int> conn_fds(workers_, -1);
+    std::mutex conn_fds_mutex;
+
+    // Stopping shuts down the listening socket and all connections, so
+    // every worker returns.
+    std::atomic<bool> stopping {false};
+    auto stop = [&]()
+                {
+                    if (stopping.exchange(true)) {
+                        return;
+                    }
+
+                    shutdown(listen_fd, SHUT_RDWR);
+
+                    std::lock_guard<std::mutex> lock(conn_fds_mutex);
+                    for (int fd: conn_fds) {
+                        if (fd >= 0) {
+                            shutdown(fd, SHUT_RDWR);
+                        }
+                    }
+                };
+
+    // Termination signals are taken by a separate thread (workers inherit
+    // the blocked mask), so the daemon stops and removes its socket file.
+    sigset_t signals;
+    sigset_t old_signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &old_signals);
+
+    std::thread signal_waiter([&]()
+                              {
+                                  timespec timeout {0, 100000000};
+                                  while (not stopping) {
+                                      if (sigtimedwait(&signals,
+                                                       nullptr,
+                                                       &timeout) > 0) {
+                                          stop();
+                                      }
+                                  }
+                              });
+
+    // Every worker serves one connection at a time. If accepting fails
+    // in one worker, the daemon is stopped with the error.
+    std::exception_ptr error;
+    try {
+        parallel_for(workers_,
+                     workers_,
+                     [&](unsigned worker_num, std::size_t)
+                     {
+                         while (not stopping) {
+                             int fd = accept(listen_fd, nullptr, nullptr);
+                             if (fd < 0 and stopping) {
+                                 return;
+                             }
+
+                             if (fd < 0) {
+                                 if (errno == EINTR or
+                                         errno == ECONNABORTED) {
+                                     continue;
+                                 }
+
+                                 // Lack of descriptors or memory passes
+                                 // when other connections are closed.
+                                 if (errno == EMFILE or errno == ENFILE or
+                                         errno == ENOBUFS or
+                                         errno == ENOMEM) {
+                                     std::this_thread::sleep_for(
+                                             std::chrono::milliseconds(10));
+                                     continue;
+                                 }
+
+                                 stop();
+                                 throw std::string("Error: Can't accept "
+                                                   "connection");
+                             }
+
+                             Connection conn(fd);
+                             {
+                                 std::lock_guard<std::mutex> lock(
+                                         conn_fds_mutex);
+                                 conn_fds[worker_num] = fd;
+                                 if (stopping) {
+                                     shutdown(fd, SHUT_RDWR);
+                                 }
+                             }
+
+                             // Broken connection or bad client doesn't
+                             // stop the daemon.
+                             try {
+                                 serve_connection(conn, serv_confs);
+
+                             } catch (const std::string& err_message) {
+                                 std::cerr << err_message << std::endl;
+
+                             } catch (const std::exception& exception) {
+                                 std::cerr << "Error: " << exception.what()
+                                           << std::endl;
+                             }
+
+                             // The socket is forgotten before it is
+                             // closed with the connection.
+                             std::lock_guard<std::mutex> lock(
+                                     conn_fds_mutex);
+                             conn_fds[worker_num] = -1;
+                         }
+                     });
+
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    stop();
+    signal_waiter.join();
+    pthread_sigmask(SIG_SETMASK, &old_signals, nullptr);
+
+    close(listen_fd);
+    unlink(socket_path.c_str());
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void RecourceDistributor::serve_connection(
+        Connection& conn,
+        const std::unordered_map<int, std::shared_ptr<const PreparedConf>>&
+                serv_confs) const
+{
+    auto find_serv = [&serv_confs](int serv_conf_num) -> const PreparedConf&
+                     {
+                         auto serv_it = serv_confs.find(serv_conf_num);
+                         if (serv_it == serv_confs.end()) {
+                             throw std::string(
+                                     "Error: Unknown server configuration " +
+                                     std::to_string(serv_conf_num));
+                         }
+
+                         return *serv_it->second;
+                     };
+
+    // Online placement of the connection, it is started by ONLINE request
+    // and kept until the connection is closed.
+    std::unique_ptr<OnlinePlacement> online;
+
+    std::string line;
+    std::string data;
+    while (conn.read_line(line)) {
+        std::istringstream request(line);
+        std::string command;
+        request >> command;
+
+        int serv_conf_num = 0;
+        if (command == "PLACE") {
+            std::size_t size;
+            if (!(request >> serv_conf_num >> size)) {
+                // Data of the request can't be skipped, so the connection
+                // is closed.
+                conn.write_all("ERROR Error: Bad request\n");
+                return;
+            }
+
+            if (size > max_request_size_) {
+                conn.write_all("ERROR Error: Too big request\n");
+                return;
+            }
+
+            if (!conn.read_exact(data, size)) {
+                return;
+            }
+
+        } else if (command != "ONLINE" and
+                   command != "ADD" and
+                   command != "REMOVE") {
+            conn.write_all("ERROR Error: Bad request\n");
+            return;
+        }
+
+        std::string answer;
+        try {
+            if (command == "PLACE") {
+                answer = answer_placement(find_serv(serv_conf_num),
+                                          serv_conf_num,
+                                          data);
+
+            } else if (command == "ONLINE") {
+                std::string critical;
+                if (!(request >> serv_conf_num >> critical) or
+                        (critical != "cores" and critical != "ram")) {
+                    throw std::string("Error: Bad request");
+                }
+
+                bool core_num_is_critical = critical == "cores";
+                online = std::make_unique<OnlinePlacement>(
+                        find_serv(serv_conf_num).sorted_by(
+                                core_num_is_critical),
+                        core_num_is_critical,
+                        policy_);
+
+            } else if (not online) {
+                throw std::string("Error: Online placement isn't started");
+
+            } else if (command == "ADD") {
+                unsigned core_num;
+                unsigned ram;
+                if (!(request >> core_num >> ram)) {
+                    throw std::string("Error: Bad request");
+                }
+
+                OnlinePlacement::VmHandle vm =
+                        online->add_vm(Item(0, core_num, ram));
+                if (vm == OnlinePlacement::no_vm) {
+                    throw std::string("Error: No server can contain VM");
+                }
+
+                answer = std::to_string(vm) + " -> " +
+                         std::to_string(online->server_of(vm)) + "\n";
+
+            } else {
+                OnlinePlacement::VmHandle vm;
+                if (!(request >> vm)) {
+                    throw std::string("Error: Bad request");
+                }
+
+                online->remove_vm(vm);
+            }
+
+        } catch (const std::string& err_message) {
+            conn.write_all("ERROR " + err_message + "\n");
+            continue;
         }
+
+        conn.write_all("OK " + std::to_string(answer.size()) + "\n" +
+                       answer);
+    }
+}
+
+std::string RecourceDistributor::answer_placement(const PreparedConf& serv,
+                                                  int serv_conf_num,
+                                                  std::string& data) const
+{
+    ParsingResult<> req_conf = parse_conf_data(data.data(), data.size());
+    ConfStats req_stats(req_conf.charact_vect);
+
+    std::string reason;
+    if (skip_infeasible_) {
+        reason = find_infeasibility(req_stats, serv.stats);
     }
+
+    std::ostringstream ss;
+    if (not reason.empty()) {
+        print_rejection(ss, req_conf.conf_num, serv_conf_num, reason);
+
+    } else {
+        bool core_num_is_critical = is_core_num_critical(req_stats,
+                                                         serv.stats);
+
+        sort_conf(req_conf, core_num_is_critical, true);
+
+        const auto& serv_conf = serv.sorted_by(core_num_is_critical);
+
+        print_depl(ss,
+                   place_sorted(req_conf,
+                                serv_conf,
+                                core_num_is_critical,
+                                limit_),
+                   req_conf, serv_conf);
+    }
+
+    return ss.str();
+}
+
+ParsingResult<>
+RecourceDistributor::load_conf(const std::string& input_file)
+{
+    MappedFile file(input_file);
+
+    return parse_conf_data(file.data(), file.size());
+}
+
+ParsingResult<>
+RecourceDistributor::parse_conf_data(char* data, std::size_t size)
+{
+    if (size >= sizeof(BinConfHeader) and
+            std::memcmp(data,
+                        BinConfHeader::valid_magic,
+                        sizeof(BinConfHeader::valid_magic)) == 0) {
+        return parse_bin_data(data, size);
+    }
+
+    return parse_xml_data(data, size);
+}
+
+void RecourceDistributor::save_bin_conf(const ParsingResult<>& conf,
+                                        const std::string& output_file)
+{
+    BinConfHeader header;
+    std::memcpy(header.magic,
+                BinConfHeader::valid_magic,
+                sizeof(header.magic));
+    header.byte_order = BinConfHeader::native_byte_order;
+    header.version = BinConfHeader::valid_version;
+    header.conf_num = conf.conf_num;
+    header.item_num = conf.charact_vect.size();
+
+    std::vector<uint32_t> columns(2 * header.item_num);
+    for (unsigned i = 0; i < header.item_num; i++) {
+        columns[i] = conf.charact_vect[i].core_num;
+        columns[header.item_num + i] = conf.charact_vect[i].ram;
+    }
+
+    std::ofstream ofile(output_file, std::ios_base::binary);
+    if (!ofile) {
+        throw std::string("File problem (probably invalid filename)");
+    }
+
+    ofile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofile.write(reinterpret_cast<const char*>(columns.data()),
+                columns.size() * sizeof(uint32_t));
+    if (!ofile) {
+        throw std::string("Error: Can't write binary configuration");
+    }
+}
+
+ParsingResult<>
+RecourceDistributor::parse_bin_data(const char* data, std::size_t size)
+{
+    BinConfHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    if (header.byte_order != BinConfHeader::native_byte_order) {
+        throw std::string("Error: Binary configuration has other byte "
+                          "order or old version, convert it again");
+    }
+
+    if (header.version != BinConfHeader::valid_version or
+            size != sizeof(header) +
+                    2 * sizeof(uint32_t) * std::size_t(header.item_num)) {
+        throw std::string("Error: Invalid binary configuration");
+    }
+
+    const char* core_num_column = data + sizeof(header);
+    const char* ram_column =
+            core_num_column + sizeof(uint32_t) * header.item_num;
+
+    CharactVect output_vect(header.item_num);
+    for (unsigned i = 0; i < header.item_num; i++) {
+        uint32_t core_num;
+        uint32_t ram;
+        std::memcpy(&core_num,
+                    core_num_column + sizeof(uint32_t) * i,
+                    sizeof(uint32_t));
+        std::memcpy(&ram, ram_column + sizeof(uint32_t) * i, sizeof(uint32_t));
+
+        output_vect[i] = Item(i, core_num, ram);
+    }
+
+    return ParsingResult(std::move(header.conf_num),
+                         std::move(output_vect));
 }
 
 ParsingResult<>
-RecourceDistributor::parse_xml_data(const std::string& input_file)
+RecourceDistributor::parse_xml_data(char* data, std::size_t size)
 {
+    // The data is parsed in place with minimal options: configurations
+    // contain only elements with numeric attributes.
     pugi::xml_document doc;
-    if (!doc.load_file(input_file.c_str())) {
+    if (!doc.load_buffer_inplace(data, size, pugi::parse_minimal)) {
         throw std::string("Error: Can't load XML file");
     }
 
     CharactVect output_vect;
-    
+
     auto conf = doc.child("configuration");
     unsigned i = 0;
-    for (const auto& node: conf) {
-        output_vect.emplace_back(Item(
-                i,
-                node.attribute("core_num").as_int(),
-                node.attribute("ram").as_int()));
+    for (const auto& node: conf.children()) {
+        if (node.type() != pugi::node_element) {
+            continue;
+        }
+
+        // Attributes are written as core_num, ram by generate_data.py,
+        // so they are taken by position. Other files fall back to the
+        // lookup by name.
+        auto core_num = node.first_attribute();
+        auto ram = core_num.next_attribute();
+        if (std::strcmp(core_num.name(), "core_num") != 0 or
+                std::strcmp(ram.name(), "ram") != 0) {
+            core_num = node.attribute("core_num");
+            ram = node.attribute("ram");
+        }
+
+        output_vect.emplace_back(Item(i, core_num.as_uint(), ram.as_uint()));
 
         i += 1;
     }
@@ -55,151 +1459,315 @@ RecourceDistributor::parse_xml_data(const std::string& input_file)
                          std::move(output_vect));
 }
 
-VmDeployment RecourceDistributor::algorithm(ParsingResult<>& req_conf,
-                                            ParsingResult<>& serv_conf,
-                                            CharactVect& serv_load,
-                                            bool enable_lim_sch)
+VmDeployment RecourceDistributor::place(ParsingResult<>& req_conf,
+                                        ParsingResult<>& serv_conf) const
+{
+    bool core_num_is_critical =
+            is_core_num_critical(ConfStats(req_conf.charact_vect),
+                                 ConfStats(serv_conf.charact_vect));
+
+    sort_conf(req_conf, core_num_is_critical, true);
+    sort_conf(serv_conf, core_num_is_critical, false);
+
+    return place_sorted(req_conf, serv_conf, core_num_is_critical, limit_);
+}
+
+VmDeployment
+RecourceDistributor::place_sorted(const ParsingResult<>& req_conf,
+                                  const ParsingResult<>& serv_conf,
+                                  bool core_num_is_critical,
+                                  unsigned limit) const
+{
+    PlacementContext ctx(arena_size(req_conf, serv_conf));
+    ctx.core_num_is_critical = core_num_is_critical;
+    ctx.limit = limit;
+
+    ServerWorkspace ws(serv_conf.charact_vect);
+
+    return algorithm(ctx, req_conf, serv_conf, ws);
+}
+
+PlacementCheckpoint
+RecourceDistributor::place_prefix(PlacementContext& ctx,
+                                  const ParsingResult<>& req_conf,
+                                  const ParsingResult<>& serv_conf) const
+{
+    PlacementCheckpoint checkpoint {
+            VmDeployment(req_conf.conf_num,
+                         serv_conf.conf_num,
+                         req_conf.charact_vect.size(),
+                         serv_conf.charact_vect.size()),
+            ServerWorkspace(serv_conf.charact_vect)};
+
+    checkpoint.next_vm = deploy_from(ctx,
+                                     req_conf,
+                                     serv_conf,
+                                     checkpoint.vm_depl,
+                                     checkpoint.ws,
+                                     0,
+                                     true,
+                                     true,
+                                     std::pmr::get_default_resource());
+
+    return checkpoint;
+}
+
+VmDeployment
+RecourceDistributor::place_from(PlacementContext& ctx,
+                                const PlacementCheckpoint& checkpoint,
+                                const ParsingResult<>& req_conf,
+                                const ParsingResult<>& serv_conf) const
+{
+    VmDeployment vm_depl = checkpoint.vm_depl;
+    ServerWorkspace ws = checkpoint.ws;
+
+    deploy_from(ctx,
+                req_conf,
+                serv_conf,
+                vm_depl,
+                ws,
+                checkpoint.next_vm,
+                true,
+                false,
+                std::pmr::get_default_resource());
+
+    return vm_depl;
+}
+
+std::size_t RecourceDistributor::arena_size(const ParsingResult<>& req_conf,
+                                            const ParsingResult<>& serv_conf)
+{
+    // Arena is big enough for scratch containers of limited search in
+    // most cases: candidate servers and subconfigurations with the
+    // deployment of them.
+    return 16 * serv_conf.charact_vect.size() +
+           128 * req_conf.charact_vect.size() +
+           4096;
+}
+
+void RecourceDistributor::sort_conf(ParsingResult<>& conf,
+                                    bool by_core_num,
+                                    bool ascending)
+{
+    auto key = [by_core_num](const Item& item)
+               {
+                   return by_core_num ? item.core_num : item.ram;
+               };
+
+    if (ascending) {
+        std::sort(conf.charact_vect.begin(),
+                  conf.charact_vect.end(),
+                  [&key](const Item& left, const Item& right)
+                  {
+                      return key(left) < key(right);
+                  });
+
+    } else {
+        std::sort(conf.charact_vect.begin(),
+                  conf.charact_vect.end(),
+                  [&key](const Item& left, const Item& right)
+                  {
+                      return key(left) > key(right);
+                  });
+    }
+}
+
+PreparedConf RecourceDistributor::prepare_conf(ParsingResult<> conf,
+                                               bool ascending)
+{
+    PreparedConf prepared {conf, conf, ConfStats(conf.charact_vect)};
+
+    sort_conf(prepared.by_core_num, true, ascending);
+    sort_conf(prepared.by_ram, false, ascending);
+
+    return prepared;
+}
+
+bool RecourceDistributor::is_core_num_critical(const ConfStats& req_stats,
+                                               const ConfStats& serv_stats)
+{
+    // Critical resource is the one of which servers have less relative
+    // to the demand of VMs.
+    return static_cast<double>(serv_stats.sum_core_num) /
+                   req_stats.sum_core_num <
+           static_cast<double>(serv_stats.sum_ram) / req_stats.sum_ram;
+}
+
+std::string
+RecourceDistributor::find_infeasibility(const ConfStats& req_stats,
+                                        const ConfStats& serv_stats)
+{
+    // Total demand of VMs can't exceed total capacity of servers.
+    if (req_stats.sum_core_num > serv_stats.sum_core_num) {
+        return "total cores number of VMs exceeds capacity of servers";
+    }
+
+    if (req_stats.sum_ram > serv_stats.sum_ram) {
+        return "total RAM of VMs exceeds capacity of servers";
+    }
+
+    // Every VM should fit into the largest server.
+    if (req_stats.max_core_num > serv_stats.max_core_num) {
+        return "some VM has more cores than any server";
+    }
+
+    if (req_stats.max_ram > serv_stats.max_ram) {
+        return "some VM has more RAM than any server";
+    }
+
+    // Two VMs of 2^k or more of a resource can't share a server if
+    // 2^(k + 1) is more than any server has, so such VMs need distinct
+    // servers with at least 2^k of the resource.
+    auto fits_big_vms = [](const std::array<unsigned,
+                                            ConfStats::bucket_num>& vm_hist,
+                           const std::array<unsigned,
+                                            ConfStats::bucket_num>& serv_hist,
+                           unsigned max_serv)
+                        {
+                            unsigned vm_num = 0;
+                            unsigned serv_num = 0;
+                            for (unsigned k = ConfStats::bucket_num - 1;
+                                 k > 0;
+                                 k--) {
+                                vm_num += vm_hist[k];
+                                serv_num += serv_hist[k];
+                                if ((std::uint64_t {2} << k) > max_serv and
+                                    vm_num > serv_num) {
+                                    return false;
+                                }
+                            }
+
+                            return true;
+                        };
+
+    if (not fits_big_vms(req_stats.core_num_hist,
+                         serv_stats.core_num_hist,
+                         serv_stats.max_core_num)) {
+        return "VMs with more than half of cores of the largest server "
+               "outnumber servers";
+    }
+
+    if (not fits_big_vms(req_stats.ram_hist,
+                         serv_stats.ram_hist,
+                         serv_stats.max_ram)) {
+        return "VMs with more than half of RAM of the largest server "
+               "outnumber servers";
+    }
+
+    return std::string();
+}
+
+template <typename T>
+VmDeployment RecourceDistributor::algorithm(PlacementContext& ctx,
+                                            const ParsingResult<T>& req_conf,
+                                            const ParsingResult<T>& serv_conf,
+                                            ServerWorkspace& ws,
+                                            bool enable_lim_sch,
+                                            std::pmr::memory_resource* mr) const
 {
     // Disabled limited search means that this function was called within
     // limited_search procedure and we don't need to call limited search
     // again.
-    // If it is enabled we need to find critical resource and
-    // sort lists of data according to this resource.
-    if (enable_lim_sch) {
-        unsigned sum_core_num_vm = 0;
-        unsigned sum_ram_vm = 0;
-        unsigned sum_core_num_serv = 0;
-        unsigned sum_ram_serv = 0;
-        for (const auto& req: req_conf.charact_vect) {
-            sum_core_num_vm += req.core_num;
-            sum_ram_vm += req.ram;
-        }
 
-        for (const auto& serv: serv_conf.charact_vect) {
-            sum_core_num_serv += serv.core_num;
-            sum_ram_serv += serv.ram;
-        }
+    VmDeployment vm_depl(req_conf.conf_num,
+                         serv_conf.conf_num,
+                         req_conf.charact_vect.size(),
+                         serv_conf.charact_vect.size(),
+                         mr);
+
+    deploy_from(ctx,
+                req_conf,
+                serv_conf,
+                vm_depl,
+                ws,
+                0,
+                enable_lim_sch,
+                false,
+                mr);
 
-        // Critical resource -> number of cores.
-        if (static_cast<double>(sum_core_num_serv) / sum_core_num_vm <
-            static_cast<double>(sum_ram_serv) / sum_ram_vm) {
-
-            core_num_is_critical_ = true;
-
-            auto comparator_less = [](const Item& left, const Item& right)
-                                   {
-                                       return left.core_num < right.core_num;
-                                   };
-
-            auto comparator_gr = [](const Item& left, const Item& right)
-                                 {
-                                     return left.core_num > right.core_num;
-                                 };
-
-            std::sort(req_conf.charact_vect.begin(),
-                      req_conf.charact_vect.end(),
-                      comparator_less);
-
-            std::sort(serv_conf.charact_vect.begin(),
-                      serv_conf.charact_vect.end(),
-                      comparator_gr);
-        
-        // Critical resource -> RAM.
-        } else {
-            core_num_is_critical_ = false;
-
-            auto comparator_less = [](const Item& left, const Item& right)
-                                   {
-                                       return left.ram < right.ram;
-                                   };
-
-            auto comparator_gr = [](const Item& left, const Item& right)
-                                 {
-                                     return left.ram > right.ram;
-                                 };
-
-            std::sort(req_conf.charact_vect.begin(),
-                      req_conf.charact_vect.end(),
-                      comparator_less);
-
-            std::sort(serv_conf.charact_vect.begin(),
-                      serv_conf.charact_vect.end(),
-                      comparator_gr);
-        }
-    }
+    return vm_depl;
+}
 
-    VmDeployment vm_depl(req_conf.conf_num, serv_conf.conf_num);
+template <typename T>
+unsigned RecourceDistributor::deploy_from(PlacementContext& ctx,
+                                          const ParsingResult<T>& req_conf,
+                                          const ParsingResult<T>& serv_conf,
+                                          VmDeployment& vm_depl,
+                                          ServerWorkspace& ws,
+                                          unsigned first_vm,
+                                          bool enable_lim_sch,
+                                          bool stop_at_failure,
+                                          std::pmr::memory_resource* mr) const
+{
+    // Selector depends only on free resources of servers, so it is built
+    // from the workspace of already deployed VMs.
+    ServerSelector selector(policy_, ctx.core_num_is_critical, ws, mr);
 
     // Greedy algorithm.
-    for (unsigned i = 0; i < req_conf.charact_vect.size(); i++) {
-        unsigned j = 0;
-        bool was_depl_succ = false;
-        while (j < serv_conf.charact_vect.size() and not was_depl_succ) {
-            was_depl_succ = try_deploy_vm(vm_depl,
-                                          i, j,
-                                          req_conf,
-                                          serv_conf,
-                                          serv_load);
-            if (was_depl_succ) {
-                vm_depl.deployed_vm_num += 1;
-                if (vm_depl.deployed_vm_num == req_conf.charact_vect.size()) {
-                    vm_depl.was_all_vm_deployed = true;
-                }
-            
-            } else if (j == serv_conf.charact_vect.size() - 1 and
-                       enable_lim_sch) {
+    for (unsigned i = first_vm; i < req_conf.charact_vect.size(); i++) {
+        unsigned j = selector.find(req_conf.charact_vect[i]);
+        if (j < serv_conf.charact_vect.size()) {
+            try_deploy_vm(vm_depl, i, j, req_conf.charact_vect[i], ws);
+
+            selector.update(j);
+
+            vm_depl.deployed_vm_num += 1;
+            if (vm_depl.deployed_vm_num == req_conf.charact_vect.size()) {
+                vm_depl.was_all_vm_deployed = true;
+            }
+
+        } else if (stop_at_failure) {
+            return i;
+
+        } else if constexpr (std::is_same_v<T, CharactVect>) {
+            if (not serv_conf.charact_vect.empty() and enable_lim_sch) {
                 // Current VM wasn't deployed on any server => run
                 // limited search procedure.
-                limited_search(vm_depl,
-                                  i,
-                                  req_conf,
-                                  serv_conf,
-                                  serv_load);
+                limited_search(ctx,
+                               selector,
+                               vm_depl,
+                               i,
+                               req_conf,
+                               serv_conf,
+                               ws);
             }
-            
-            j += 1;
         }
     }
 
-    return vm_depl;
+    return req_conf.charact_vect.size();
 }
     
-void RecourceDistributor::print_depl_to_file(const VmDeployment& vm_depl,
-                                             const ParsingResult<>& req_conf,
-                                             const ParsingResult<>& serv_conf)
+void RecourceDistributor::print_depl(std::ostream& ofile,
+                                     const VmDeployment& vm_depl,
+                                     const ParsingResult<>& req_conf,
+                                     const ParsingResult<>& serv_conf) const
 {
-    // Just the pretty print into an output file.
-
-    std::ofstream ofile(output_filename_, std::ios_base::app);
-    if (!ofile) {
-        throw std::string("File problem (probably invalid filename)");
-    }
+    // Just the pretty print into an output stream.
 
     ofile << "Request configuration #" << vm_depl.req_conf_num
-          << std::endl;
+          << '\n';
 
     ofile << "Server configuration #" << vm_depl.serv_conf_num
-          << std::endl;
+          << '\n';
 
-    ofile << "\n=== DEPLOYMENT ===" << std::endl;
+    ofile << "\n=== DEPLOYMENT ===\n";
 
-    std::vector<std::pair<unsigned, unsigned>> depl_vect(
-            vm_depl.vm_mapping.begin(), vm_depl.vm_mapping.end());
-
-    auto comparator = [&req_conf](const auto& left, const auto& right)
-                      {
-                          return req_conf.charact_vect[left.first].num <
-                                 req_conf.charact_vect[right.first].num;
-                      };
+    // Configurations are sorted by the algorithm, so put server numbers
+    // in the initial order of VMs.
+    std::vector<uint32_t> depl_vect(vm_depl.vm_mapping.size(),
+                                    VmDeployment::unplaced);
 
-    std::sort(depl_vect.begin(),
-              depl_vect.end(),
-              comparator);
+    for (unsigned i = 0; i < vm_depl.vm_mapping.size(); i++) {
+        if (vm_depl.vm_mapping[i] != VmDeployment::unplaced) {
+            depl_vect[req_conf.charact_vect[i].num] =
+                    serv_conf.charact_vect[vm_depl.vm_mapping[i]].num;
+        }
+    }
 
-    for (const auto& it: depl_vect) {
-        ofile << req_conf.charact_vect[it.first].num
-              << " -> "
-              << serv_conf.charact_vect[it.second].num << std::endl;
+    for (unsigned i = 0; i < depl_vect.size(); i++) {
+        if (depl_vect[i] != VmDeployment::unplaced) {
+            ofile << i << " -> " << depl_vect[i] << '\n';
+        }
     }
 
     std::stringstream ss;
@@ -211,43 +1779,53 @@ void RecourceDistributor::print_depl_to_file(const VmDeployment& vm_depl,
         dashes << "-";
     }
 
-    ofile << dashes.str() << std::endl
-          << ss.str() << std::endl;
+    ofile << dashes.str() << '\n'
+          << ss.str() << '\n';
 
     if (vm_depl.was_all_vm_deployed) {
-        ofile << "All VM deployed: True" << std::endl;
+        ofile << "All VM deployed: True\n";
     
     } else {
-        ofile << "All VM deployed: False" << std::endl;
+        ofile << "All VM deployed: False\n";
     }
 
-    ofile << dashes.str() << "\n\n\n" << std::endl;
+    ofile << dashes.str() << "\n\n\n\n";
+}
+
+void RecourceDistributor::print_rejection(std::ostream& ofile,
+                                          int req_conf_num,
+                                          int serv_conf_num,
+                                          const std::string& reason) const
+{
+    ofile << "Request configuration #" << req_conf_num
+          << '\n';
+
+    ofile << "Server configuration #" << serv_conf_num
+          << '\n';
+
+    ofile << "\n=== DEPLOYMENT ===\n";
+
+    ofile << "Skipped: " << reason << '\n';
+
+    std::string dashes(std::string("All VM deployed: False").length(), '-');
+
+    ofile << dashes << '\n'
+          << "All VM deployed: False\n"
+          << dashes << "\n\n\n\n";
 }
 
 bool RecourceDistributor::try_deploy_vm(VmDeployment& vm_depl,
                                         unsigned vm_num,
                                         unsigned serv_num,
-                                        const ParsingResult<>& req_conf,
-                                        const ParsingResult<>& serv_conf,
-                                        CharactVect& serv_load)
+                                        const Item& vm,
+                                        ServerWorkspace& ws) const
 {
-    // If current server can contain this VM add VM characteristics
-    // into the load list adn return true value.
+    // If current server can contain this VM take VM characteristics
+    // from the free resources of server and return true value.
     // Else return false value.
-    if (serv_load[serv_num].core_num +
-        req_conf.charact_vect[vm_num].core_num <=
-        serv_conf.charact_vect[serv_num].core_num
-        and
-        serv_load[serv_num].ram +
-        req_conf.charact_vect[vm_num].ram <=
-        serv_conf.charact_vect[serv_num].ram) {
-        
-        vm_depl.vm_mapping[vm_num] = serv_num;
-        
-        serv_load[serv_num].core_num +=
-                req_conf.charact_vect[vm_num].core_num;
-        
-        serv_load[serv_num].ram += req_conf.charact_vect[vm_num].ram;
+    if (ws.fits(serv_num, vm)) {
+        vm_depl.deploy(vm_num, serv_num);
+        ws.take(serv_num, vm);
 
         return true;
     
@@ -257,193 +1835,206 @@ bool RecourceDistributor::try_deploy_vm(VmDeployment& vm_depl,
 }
 
 void
-RecourceDistributor::limited_search(VmDeployment& vm_depl,
-                                       unsigned vm_num,
-                                       const ParsingResult<>& req_conf,
-                                       const ParsingResult<>& serv_conf,
-                                       CharactVect& serv_load)
-{
-    // The vector which will be filled with pairs of the form
-    // <server_number : available_number_of_critical_resource>.
-    using ServForSearch = std::pair<unsigned, unsigned>;
-    std::vector<ServForSearch> serv_for_search;
-
-    // Find servers which can contain current VM.
-    for (unsigned j = 0; j < serv_conf.charact_vect.size(); j++) {
-        // If current server can contain the VM according to the
-        // critical resource we add it to the list of servers for
-        // limited search.
-        if (((serv_conf.charact_vect[j].core_num >=
-                req_conf.charact_vect[vm_num].core_num) and
-                core_num_is_critical_)
-                or
-                ((serv_conf.charact_vect[j].ram >=
-                req_conf.charact_vect[vm_num].ram) and
-                not core_num_is_critical_)) {
-            
-            if (core_num_is_critical_) {
-                serv_for_search.emplace_back(std::make_pair(
-                        j,
-                        serv_conf.charact_vect[j].core_num - 
-                        serv_load[j].core_num));
-
-            } else {
-                serv_for_search.emplace_back(std::make_pair(
-                        j,
-                        serv_conf.charact_vect[j].ram - 
-                        serv_load[j].ram));
-            }
-        }
+RecourceDistributor::limited_search(PlacementContext& ctx,
+                                    ServerSelector& selector,
+                                    VmDeployment& vm_depl,
+                                    unsigned vm_num,
+                                    const ParsingResult<>& req_conf,
+                                    const ParsingResult<>& serv_conf,
+                                    ServerWorkspace& ws) const
+{
+    // All scratch containers below take memory from the arena. Containers
+    // of the previous search are already destroyed, so it can be reset.
+    ctx.arena.release();
+    std::pmr::memory_resource* mr = &ctx.arena;
+
+    auto critical = [&ctx](const Item& item)
+                    {
+                        return ctx.core_num_is_critical ? item.core_num
+                                                        : item.ram;
+                    };
+
+    // Servers are sorted by critical resource in descending order, so
+    // the servers which can contain current VM according to it form
+    // a prefix of configuration.
+    unsigned need = critical(req_conf.charact_vect[vm_num]);
+    unsigned serv_end = std::partition_point(
+            serv_conf.charact_vect.begin(),
+            serv_conf.charact_vect.end(),
+            [&](const Item& serv)
+            {
+                return critical(serv) >= need;
+            }) - serv_conf.charact_vect.begin();
+
+    // No server can contain current VM even being empty, so the search
+    // can't succeed.
+    if (serv_end == 0) {
+        return;
     }
 
-    // Sort our new list in ascending order.
-    auto comparator = [](const ServForSearch& left, const ServForSearch& right)
-                      {
-                          return left.second > right.second;
-                      };
-
-    std::sort(serv_for_search.begin(),
-              serv_for_search.end(),
-              comparator);
-
     // Try to redeploy VM from servers for searching with greedy algorithm.
 
-    // Subconfiguration of VM and server configurations which contain
-    // the piece of data to redeploy.
-    ParsingResult<CharactVectWithIndices> req_subconf;
-    ParsingResult<CharactVectWithIndices> serv_subconf;
-    
-    // Mappings of subconfiguration index to configuration index to
-    // keep correspondence between theese two structures after sorting.
-    std::map<unsigned, unsigned> req_subconf_to_conf;
-    std::map<unsigned, unsigned> serv_subconf_to_conf;
-    
-    req_subconf.charact_vect.emplace_back(
-            std::make_pair(req_conf.charact_vect[vm_num],
-                           vm_num));
-
-    unsigned limit = limit_ <= serv_for_search.size() ?
-            limit_ : serv_for_search.size();
-
-    // Fill subconfigurations of VM and servers to run greedy algorithm with
-    // the needed piece of data.
-    for (unsigned i = 0; i < limit; i++) {
-        // Add every server from the list for search to the new
-        // server subconfiguration.
-        serv_subconf.charact_vect.emplace_back(
-                std::make_pair(
-                    serv_conf.charact_vect[serv_for_search[i].first],
-                    serv_for_search[i].first));
-
-        // Add every VM which was deployed on the current server to the new
-        // vm subconfiguration.
-        for (const auto& it: vm_depl.vm_mapping) {
-            if (it.second == serv_for_search[i].first) {
-                
-                req_subconf.charact_vect.emplace_back(
-                        std::make_pair(
-                            req_conf.charact_vect[it.first],
-                            it.first));
-            }
-        }
+    // Subconfigurations of VM and server configurations which contain
+    // the piece of data to redeploy. They are kept as mappings of
+    // subconfiguration index to configuration index: i-th item of
+    // subconfiguration is item req_subconf_to_conf[i] of configuration.
+    std::pmr::vector<unsigned> req_subconf_to_conf(mr);
+    std::pmr::vector<unsigned> serv_subconf_to_conf(mr);
+
+    // Servers for search are the ones with the most of remaining
+    // critical resource, they are taken from the ordered index of
+    // selector without sorting all servers.
+    selector.collect_by_remaining(serv_end, ctx.limit, serv_subconf_to_conf);
+
+    // Add every VM which was deployed on the servers for search to the new
+    // vm subconfiguration.
+    req_subconf_to_conf.push_back(vm_num);
+    for (unsigned j: serv_subconf_to_conf) {
+        vm_depl.for_each_vm_on(j,
+                               [&](uint32_t k)
+                               {
+                                   req_subconf_to_conf.push_back(k);
+                               });
     }
 
     // Sort subconfiguration according to the critical resource.
-    if (core_num_is_critical_) {
-        auto comparator_less = [](const auto& left, const auto& right)
-                               {
-                                   return left.first.core_num <
-                                          right.first.core_num;
-                               };
+    // VMs with equal resource are kept in the order of configuration, so
+    // the result doesn't depend on the order of collecting them.
+    auto comparator_less = [&](unsigned left, unsigned right)
+                           {
+                               const auto& vms = req_conf.charact_vect;
+                               return std::make_pair(critical(vms[left]),
+                                                     left) <
+                                      std::make_pair(critical(vms[right]),
+                                                     right);
+                           };
+
+    auto comparator_gr = [&](unsigned left, unsigned right)
+                         {
+                             return critical(serv_conf.charact_vect[left]) >
+                                    critical(serv_conf.charact_vect[right]);
+                         };
+
+    std::sort(req_subconf_to_conf.begin() + 1,
+              req_subconf_to_conf.end(),
+              comparator_less);
+
+    std::sort(serv_subconf_to_conf.begin(),
+              serv_subconf_to_conf.end(),
+              comparator_gr);
+
+    // Views of subconfigurations for passing them to the algorithm,
+    // items stay in the configurations.
+    ParsingResult<SubconfView> req_subconf(
+            0, SubconfView {req_conf.charact_vect, req_subconf_to_conf});
+
+    ParsingResult<SubconfView> serv_subconf(
+            0, SubconfView {serv_conf.charact_vect, serv_subconf_to_conf});
+
+    // Workspace of empty servers of subconfiguration.
+    ServerWorkspace sub_ws(serv_subconf.charact_vect, mr);
 
-        auto comparator_gr = [](const auto& left, const auto& right)
-                             {
-                                 return left.first.core_num >
-                                        right.first.core_num;
-                             };
-
-        std::sort(req_subconf.charact_vect.begin() + 1,
-                  req_subconf.charact_vect.end(),
-                  comparator_less);
-
-        std::sort(serv_subconf.charact_vect.begin(),
-                  serv_subconf.charact_vect.end(),
-                  comparator_gr);
+    // Try to redeploy piece of configurations via greedy algorithm
+    // without limited search procedure.
+    VmDeployment vm_subdepl = algorithm(ctx,
+                                        req_subconf,
+                                        serv_subconf,
+                                        sub_ws,
+                                        false,
+                                        mr);
     
-    } else {
-        auto comparator_less = [](const auto& left, const auto& right)
-                               {
-                                   return left.first.ram < right.first.ram;
-                               };
-
-        auto comparator_gr = [](const auto& left, const auto& right)
-                             {
-                                 return left.first.ram > right.first.ram;
-                             };
+    // If redeployment was successful update deployment mapping and
+    // free resources of servers.
+    if (vm_subdepl.was_all_vm_deployed) {
+        for (unsigned k = 0; k < vm_subdepl.vm_mapping.size(); k++) {
+            vm_depl.deploy(req_subconf_to_conf[k],
+                           serv_subconf_to_conf[vm_subdepl.vm_mapping[k]]);
+        }
 
-        std::sort(req_subconf.charact_vect.begin() + 1,
-                  req_subconf.charact_vect.end(),
-                  comparator_less);
+        vm_depl.deployed_vm_num += 1;
+        if (vm_depl.deployed_vm_num == req_conf.charact_vect.size()) {
+            vm_depl.was_all_vm_deployed = true;
+        }
 
-        std::sort(serv_subconf.charact_vect.begin(),
-                  serv_subconf.charact_vect.end(),
-                  comparator_gr);
+        for (unsigned i = 0; i < sub_ws.size(); i++) {
+            ws.free_core_num[serv_subconf_to_conf[i]] =
+                    sub_ws.free_core_num[i];
+            ws.free_ram[serv_subconf_to_conf[i]] = sub_ws.free_ram[i];
+            selector.update(serv_subconf_to_conf[i]);
+        }
     }
+}
 
-    // Fill the mapping from subconfiguration index
-    // initial to configuration index.
-    for (unsigned i = 0; i < req_subconf.charact_vect.size(); i++) {
-        req_subconf_to_conf[i] =
-                req_subconf.charact_vect[i].second;
-    }
+OnlinePlacement::OnlinePlacement(const ParsingResult<>& serv_conf,
+                                 bool core_num_is_critical,
+                                 PlacementPolicy policy)
+    : serv_conf_ {serv_conf},
+      ws_ {serv_conf_.charact_vect},
+      vm_depl_ {0, serv_conf_.conf_num, 0, serv_conf_.charact_vect.size()},
+      selector_ {policy, core_num_is_critical, ws_}
+{}
 
-    for (unsigned i = 0; i < serv_subconf.charact_vect.size(); i++) {
-        serv_subconf_to_conf[i] =
-                serv_subconf.charact_vect[i].second;
+OnlinePlacement::VmHandle OnlinePlacement::add_vm(const Item& vm)
+{
+    unsigned serv_num = selector_.find(vm);
+    if (serv_num >= ws_.size()) {
+        return no_vm;
     }
 
-    // Load list for server subconfiguration.
-    CharactVect serv_subload =
-            std::vector(serv_subconf.charact_vect.size(), Item());
+    uint32_t slot;
+    if (not free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        vms_[slot] = Item(slot, vm.core_num, vm.ram);
 
-    // Copies of subconfiguration without indices for passing it to
-    // the algorithm and printing functions.
-    ParsingResult req_subconf_copy;
-    for (const auto& it: req_subconf.charact_vect) {
-        req_subconf_copy.charact_vect.emplace_back(it.first);
+    } else {
+        slot = vm_depl_.add_vm();
+        vms_.emplace_back(Item(slot, vm.core_num, vm.ram));
+        generations_.push_back(0);
     }
 
-    ParsingResult serv_subconf_copy;
-    for (const auto& it: serv_subconf.charact_vect) {
-        serv_subconf_copy.charact_vect.emplace_back(it.first);
+    vm_depl_.deploy(slot, serv_num);
+    vm_depl_.deployed_vm_num += 1;
+    ws_.take(serv_num, vm);
+    selector_.update(serv_num);
+
+    return VmHandle {generations_[slot]} << 32 | slot;
+}
+
+void OnlinePlacement::remove_vm(VmHandle vm)
+{
+    uint32_t slot = slot_of(vm);
+    if (slot == VmDeployment::unplaced) {
+        throw std::string("Error: Unknown VM " + std::to_string(vm));
     }
 
-    // Try to redeploy piece of configurations via greedy algorithm
-    // without limited search procedure.
-    VmDeployment vm_subdepl = algorithm(req_subconf_copy,
-                                        serv_subconf_copy,
-                                        serv_subload,
-                                        false);
-    
-    // If redeployment was successful update deployment mapping and
-    // server load list.
-    if (vm_subdepl.was_all_vm_deployed) {
-        for (const auto& it: vm_subdepl.vm_mapping) {
-            if (serv_subconf_to_conf[it.second] !=
-                    vm_depl.vm_mapping[req_subconf_to_conf[it.first]]) {
+    uint32_t serv_num = vm_depl_.release(slot);
+    ws_.give_back(serv_num, vms_[slot]);
+    selector_.update(serv_num);
 
-                vm_depl.vm_mapping[req_subconf_to_conf[it.first]] =
-                        serv_subconf_to_conf[it.second];
-            }
-        }
+    // Handles of the slot given before become invalid.
+    generations_[slot] += 1;
+    free_slots_.push_back(slot);
+}
 
-        vm_depl.deployed_vm_num += 1;
-        if (vm_depl.deployed_vm_num == req_conf.charact_vect.size()) {
-            vm_depl.was_all_vm_deployed = true;
-        }
+uint32_t OnlinePlacement::server_of(VmHandle vm) const
+{
+    uint32_t slot = slot_of(vm);
+    if (slot == VmDeployment::unplaced) {
+        return VmDeployment::unplaced;
+    }
 
-        for (unsigned i = 0; i < serv_subload.size(); i++) {
-            serv_load[serv_subconf_to_conf[i]] = serv_subload[i];
-        }
+    return serv_conf_.charact_vect[vm_depl_.vm_mapping[slot]].num;
+}
+
+uint32_t OnlinePlacement::slot_of(VmHandle vm) const
+{
+    uint32_t slot = static_cast<uint32_t>(vm);
+    if (slot >= vm_depl_.vm_mapping.size() or
+            generations_[slot] != vm >> 32 or
+            vm_depl_.vm_mapping[slot] == VmDeployment::unplaced) {
+        return VmDeployment::unplaced;
     }
+
+    return slot;
 }
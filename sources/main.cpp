@@ -1,22 +1,125 @@
 #include "header.hpp"
 
 
+// Function to parse list of searching depths like "1,3-8,10". Ranges
+// include both bounds.
+static std::vector<unsigned> parse_limits(const std::string& arg)
+{
+    std::vector<unsigned> limits;
+
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        std::size_t dash = item.find('-');
+        if (dash == std::string::npos) {
+            limits.push_back(std::stoi(item));
+
+        } else {
+            unsigned first = std::stoi(item.substr(0, dash));
+            unsigned last = std::stoi(item.substr(dash + 1));
+            if (first > last) {
+                throw std::string("Error: Bad range of lambda " + item);
+            }
+
+            for (unsigned limit = first; limit <= last; limit++) {
+                limits.push_back(limit);
+            }
+        }
+    }
+
+    if (limits.empty()) {
+        throw std::string("Error: Empty list of lambda");
+    }
+
+    return limits;
+}
+
+// Function to print command line usage.
+static void print_usage()
+{
+    std::cerr << "Usage:" << std::endl;
+    std::cerr << "    ./vm_deployer [lambda|lambda list] [workers] "
+                 "[first-fit|best-fit] [full|brief] [socket]"
+              << std::endl;
+}
+
 int main(int argc, char const* argv[])
 {
     try {
-        unsigned limit = 2;
+        // List or range of lambda means sweep mode.
+        std::vector<unsigned> limits {2};
+        bool sweep = false;
         if (argc >= 2) {
-            limit = std::stoi(argv[1]);
+            limits = parse_limits(argv[1]);
+            sweep = std::string(argv[1]).find_first_of(",-") !=
+                    std::string::npos;
         }
 
-        RecourceDistributor rd(limit);
-        rd.distributeRecources();
+        // Omitted number of workers means all hardware threads, given
+        // number should be positive.
+        unsigned workers = 0;
+        if (argc >= 3) {
+            int workers_arg = std::stoi(argv[2]);
+            if (workers_arg < 1) {
+                std::cerr << "Error: Number of workers should be at least 1"
+                          << std::endl;
+                print_usage();
+                return -1;
+            }
+
+            workers = workers_arg;
+        }
+
+        PlacementPolicy policy = PlacementPolicy::first_fit;
+        if (argc >= 4) {
+            if (std::string(argv[3]) == "best-fit") {
+                policy = PlacementPolicy::best_fit;
+
+            } else if (std::string(argv[3]) != "first-fit") {
+                throw std::string("Error: Unknown placement policy");
+            }
+        }
+
+        // Brief output mode skips pairs which provably can't be fully
+        // deployed.
+        bool skip_infeasible = false;
+        if (argc >= 5) {
+            if (std::string(argv[4]) == "brief") {
+                skip_infeasible = true;
+
+            } else if (std::string(argv[4]) != "full") {
+                throw std::string("Error: Unknown output mode");
+            }
+        }
+
+        // Path of Unix domain socket means daemon mode.
+        std::string socket_path;
+        if (argc >= 6) {
+            socket_path = argv[5];
+        }
+
+        RecourceDistributor rd(limits.front(),
+                               "../id/requests",
+                               "../id/servers",
+                               "../results/results.txt",
+                               workers,
+                               policy,
+                               skip_infeasible);
+
+        if (not socket_path.empty()) {
+            rd.serve(socket_path);
+
+        } else if (sweep) {
+            rd.sweepLimits(limits, std::cout);
+
+        } else {
+            rd.distributeRecources();
+        }
     
     // Bad cast, the user has inputed some dirt instead of integers.
     } catch (const std::invalid_argument& exception) {
         std::cerr << "Error: Bad cast" << std::endl;
-        std::cerr << "Usage:" << std::endl;
-        std::cerr << "    ./vm_deployer [lambda]" << std::endl;
+        print_usage();
         return -1;
     
     } catch (const std::string& err_message) {